@@ -1,11 +1,16 @@
 #ifndef AUDIO_H
 #define AUDIO_H
 
+#include "convert.h"
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
-constexpr size_t AUDIO_BUFFER_SIZE = 4096;
+constexpr size_t AUDIO_BUFFER_SIZE = 65536;  // frames per channel, power of two
+constexpr size_t AUDIO_MAX_CHANNELS = 8;    // up to 7.1
+constexpr size_t AUDIO_CHANNEL_NAME_LEN = 8;
+constexpr float AUDIO_WAKE_LEVEL = 1e-5f;   // -100 dBFS, block peak that ends idle
 
 typedef struct pw_thread_loop pw_thread_loop;
 typedef struct pw_stream pw_stream;
@@ -13,17 +18,33 @@ typedef struct pw_stream pw_stream;
 typedef struct {
     pw_thread_loop *loop;
     pw_stream *stream;
-    float buffer_l[AUDIO_BUFFER_SIZE];
-    float buffer_r[AUDIO_BUFFER_SIZE];
-    size_t write_pos;
+    float *buffer[AUDIO_MAX_CHANNELS];  // planar ring, one row per channel
+    char channel_names[AUDIO_MAX_CHANNELS][AUDIO_CHANNEL_NAME_LEN];
+    _Atomic uint64_t frames_written;    // total frames captured; ring slot = frames % size
+    int wake_fd;                // eventfd signalled on the first non-silent block
+    atomic_bool wake_armed;     // set by the reader while idle
     uint32_t sample_rate;
+    uint32_t channels;          // negotiated channel count (clamped to AUDIO_MAX_CHANNELS)
+    uint32_t stream_channels;   // channel count of the interleaved stream
+    convert_format_t format;    // negotiated sample format of the stream
+    bool format_known;
+    bool pw_held;               // holds a reference on the PipeWire library
     bool running;
     bool stereo;
 } audio_ctx_t;
 
+// On failure audio_shutdown still releases whatever was set up
 int audio_init(audio_ctx_t *ctx, const char *client_name);
 void audio_shutdown(audio_ctx_t *ctx);
-size_t audio_get_samples(audio_ctx_t *ctx, float *dest_l, float *dest_r, size_t count);
+size_t audio_get_samples(audio_ctx_t *ctx, float *const *dest, size_t count);
+// Copy up to max frames following *cursor (an absolute frame count) and
+// advance it; a reader that fell too far behind skips ahead
+size_t audio_read(audio_ctx_t *ctx, uint64_t *cursor, float *const *dest, size_t max);
+uint64_t audio_frames_written(audio_ctx_t *ctx);
 uint32_t audio_get_sample_rate(audio_ctx_t *ctx);
+uint32_t audio_get_channels(audio_ctx_t *ctx);
+int audio_wake_fd(audio_ctx_t *ctx);
+void audio_arm_wake(audio_ctx_t *ctx);
+void audio_ack_wake(audio_ctx_t *ctx);
 
 #endif
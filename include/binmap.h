@@ -0,0 +1,23 @@
+#ifndef BINMAP_H
+#define BINMAP_H
+
+#include <stddef.h>
+
+constexpr double BIN_MAP_MIN_FREQ = 20.0;   // low end of the column axis
+
+// Column -> spectrum bin lookup, rebuilt only when its inputs change
+typedef struct {
+    size_t *bins;
+    int count;
+    int capacity;
+    int sample_rate;
+    size_t spectrum_size;
+} bin_map_t;
+
+// Spectrum bin under column col of n; each octave gets equal width
+size_t bin_map_column(int col, int n, int sample_rate, size_t spectrum_size);
+// Cached lookup for n columns, NULL if it can't be grown
+const size_t *bin_map_get(bin_map_t *map, int sample_rate, size_t spectrum_size, int n);
+void bin_map_shutdown(bin_map_t *map);
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef CONVERT_H
+#define CONVERT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+constexpr size_t CONVERT_LANES = 8;     // frames per SIMD step
+
+// Interleaved sample formats accepted from the capture stream (native endian)
+typedef enum {
+    CONVERT_F32,
+    CONVERT_S16,
+    CONVERT_S24,                // packed, 3 bytes per sample
+    CONVERT_S32,
+} convert_format_t;
+
+size_t convert_sample_size(convert_format_t format);
+// Deinterleave count frames of a stride-channel stream into the first
+// channels planar rows, writing dest[c][offset .. offset + count) as float
+// in -1..1. Channels past the row count are skipped.
+void convert_deinterleave(convert_format_t format, const void *src, uint32_t stride, uint32_t channels,
+                          float *const *dest, size_t offset, size_t count);
+
+#endif
@@ -1,13 +1,28 @@
 #ifndef DISPLAY_H
 #define DISPLAY_H
 
+#include "binmap.h"
+#include "history.h"
+#include "kitty.h"
+#include "loudness.h"
+#include "octave.h"
+#include "peaks.h"
+#include "persistence.h"
+#include "phase.h"
+#include "tonal.h"
 #include <ncurses.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 constexpr int BAR_LEVELS = 8;
 constexpr int NUM_COLORMAPS = 4;
-constexpr int WATERFALL_HISTORY = 256;
+constexpr int DISPLAY_MAX_VIEWS = 9;    // mix + up to 8 channels
+constexpr double DISPLAY_SILENCE_RMS = 1e-5;  // -100 dBFS
+constexpr double DISPLAY_DB_RANGE = 80.0;     // dB spanned by a full-height bar
+constexpr int DISPLAY_RESERVE_COLUMNS = 512;  // bar storage reserved up front so resizes don't allocate
+constexpr double DISPLAY_STATS_SECONDS = 0.25;  // stats row RMS window and refresh period
+constexpr int DISPLAY_PEAK_BLOCKS = 12;         // stats blocks in the 3 s peak hold
 
 typedef enum {
     COLORMAP_FIRE,      // green -> yellow -> red
@@ -21,35 +36,89 @@ typedef struct {
     int width;
     int height;
     int num_bars;
-    double *bar_values;
-    double *peak_values;
-    int *peak_hold_frames;      // frames remaining before peak starts falling
-    double *waterfall;          // 2D array [height][num_bars]
-    int waterfall_pos;
+    int bar_capacity;           // columns bar_values and peaks can hold
+    float *bar_values;          // padded for peaks_update
+    peaks_t peaks;
+    history_t history;          // quantized per-bin scrollback
+    uint64_t history_due;       // capture frame at which the next history row is due
+    size_t history_new;         // rows pushed by the current update
+    bool paused;                // view anchored in history
+    size_t scroll;              // history age of the top/displayed row
+    bin_map_t bar_map;
+    bin_map_t pixel_map;
     bool use_color;
     bool use_truecolor;
+    bool use_kitty;             // pixel rendering via the kitty graphics protocol
+    kitty_ctx_t kitty;
     bool show_info;
     bool show_stats;
+    bool show_loudness;
+    loudness_reading_t loudness;    // latest meter snapshot, filled by the caller
+    bool loudness_running;      // meter measuring, possibly with its row hidden
+    bool reset_requested;       // 'x' pressed; caller resets the meters
+    bool recording;             // a triggered capture is being written
     bool waterfall_mode;
+    bool persistence_mode;      // density view of recent levels instead of bars
+    persistence_t persistence;
+    double persistence_time;    // decay time constant in seconds
+    bool show_tonal;            // top-N tonal peak overlay
+    tonal_ctx_t tonal;
+    spectrum_average_t average; // averaging mode requested for the spectrum
+    bool phase_mode;            // vectorscope and per-band coherence instead of bars
+    phase_ctx_t phase;
+    int octave_fraction;        // fractional-octave bars: 0 = off, 1, 3 or 6 per octave
+    octave_weighting_t octave_weighting;
+    float band_levels[OCTAVE_MAX_BANDS];    // normalized like the spectrum
+    double band_centres[OCTAVE_MAX_BANDS];
+    int num_bands;
     colormap_t colormap;
     double gain;
     double peak_hold_time;      // seconds before peak starts falling
+    double peak_attack;         // peak rise rate in dB/s (0 = instant)
+    double peak_release;        // peak fall rate in dB/s
+    double last_update;         // monotonic time of the previous display_update
     double max_sample;          // max absolute sample value (for stats)
     double rms_left;            // RMS level left channel
     double rms_right;           // RMS level right channel
-    double peak_history[180];   // 3 sec @ 60fps for rolling peak
-    double rms_history_l[15];   // 250ms @ 60fps for RMS window (left)
-    double rms_history_r[15];   // 250ms @ 60fps for RMS window (right)
-    int stats_frame;            // frame counter for stats update
+    double peak_history[DISPLAY_PEAK_BLOCKS];   // block peaks over the last 3 s of audio
+    int peak_index;             // next peak_history slot
+    double block_peak;          // stats block being accumulated
+    double block_sum_l, block_sum_r;
+    size_t block_frames;
     int sample_rate;            // audio sample rate for frequency calculation
     bool stereo;                // stereo input available
+    int view;                   // selected spectrum: 0 = mix, N = channel N
+    int num_views;              // mix + number of captured channels
+    const char *view_names[DISPLAY_MAX_VIEWS];
+    bool silent;                // last stats block below DISPLAY_SILENCE_RMS
+    bool settled;               // bars and peaks have fully decayed
+    bool idle_drawn;            // static (settled or paused) frame already on screen
+    bool needs_refresh;         // ncurses state changed in truecolor mode
+    bool redraw;                // input changed the view; repaint everything
+    bool resize_pending;        // KEY_RESIZE seen; re-layout once before the next frame
 } display_ctx_t;
 
 int display_init(display_ctx_t *ctx);
 void display_shutdown(display_ctx_t *ctx);
+// Feed count new frames of the front pair; the stats windows are counted
+// in samples, so they do not depend on the redraw rate
 void display_update_stats(display_ctx_t *ctx, const float *samples_l, const float *samples_r, size_t count);
-void display_update(display_ctx_t *ctx, const double *spectrum, size_t spectrum_size);
+// Draw a frame; frame is the capture position the spectrum ends at, which
+// paces the history rows
+void display_update(display_ctx_t *ctx, const double *spectrum, size_t spectrum_size, uint64_t frame);
+// Feed the phase view one hop: count new L/R frames and the transforms of
+// the window ending with them
+void display_update_phase(display_ctx_t *ctx, const float *samples_l, const float *samples_r, size_t count,
+                          const fftw_complex *bins_l, const fftw_complex *bins_r, size_t bins);
+// Track tonal peaks in one frame of unsmoothed levels
+void display_update_tonal(display_ctx_t *ctx, const double *spectrum, size_t spectrum_size);
+// Latest fractional-octave band levels in dB (0 = full-scale sine)
+void display_set_bands(display_ctx_t *ctx, const double *levels_db, const double *centres, int count);
+// Feed one STFT frame of unsmoothed levels into the persistence view
+void display_add_persistence(display_ctx_t *ctx, const double *spectrum, size_t spectrum_size);
+// Re-layout for the current terminal size, keeping peaks and history
 void display_resize(display_ctx_t *ctx);
+bool display_is_idle(const display_ctx_t *ctx);
 bool display_handle_input(display_ctx_t *ctx, int *smoothing_percent);
 
 #endif
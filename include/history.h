@@ -0,0 +1,30 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+constexpr double HISTORY_MINUTES = 5.0;
+constexpr double HISTORY_ROW_SECONDS = 1.0 / 60.0;  // captured audio per row
+
+// Spectrogram scrollback: one row per HISTORY_ROW_SECONDS of captured
+// audio, whatever the redraw rate, and one byte per FFT bin
+// (normalized level quantized to 0..255), so minutes of full-resolution
+// history fit in a few tens of MB and can be re-mapped to any width.
+typedef struct {
+    uint8_t *rows;              // ring [capacity][bins]
+    double *times;              // monotonic timestamp of each row
+    size_t bins;
+    size_t capacity;
+    size_t head;                // next row to write
+    size_t count;               // rows stored (<= capacity)
+} history_t;
+
+int history_init(history_t *history, size_t bins, size_t capacity);
+void history_shutdown(history_t *history);
+void history_push(history_t *history, const double *spectrum, double now);
+// age 0 is the newest row; NULL past the oldest stored row
+const uint8_t *history_row(const history_t *history, size_t age);
+double history_time(const history_t *history, size_t age);
+
+#endif
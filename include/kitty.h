@@ -0,0 +1,54 @@
+#ifndef KITTY_H
+#define KITTY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Renderer backend for terminals implementing the kitty graphics protocol.
+// Pixels are handed over through POSIX shared memory (t=s) or, where that
+// is unavailable, a temp file (t=t); no pixel data goes through the tty.
+// kitty_init asks the terminal to read a probe image over each medium and
+// fails when neither is answered, so the caller falls back to cells.
+
+typedef enum {
+    KITTY_IMAGE_NONE,
+    KITTY_IMAGE_SPECTRUM,       // whole image re-sent each frame
+    KITTY_IMAGE_WATERFALL       // ring of rows, normally only new rows are sent
+} kitty_image_t;
+
+typedef struct {
+    uint32_t image_id;
+    int top_row;                // first terminal row covered (0-based)
+    int cols, rows;             // cells covered
+    int cell_w, cell_h;         // pixels per cell
+    int width, height;          // image size in pixels
+    kitty_image_t content;
+    int ring_pos;               // waterfall: image row holding the newest line
+    bool use_shm;
+    unsigned seq;               // unique suffix for shm objects and temp files
+    uint8_t *staging;           // rows being prepared (temp-file medium)
+    uint8_t *mapped;            // rows being prepared (shm medium)
+    size_t pending_bytes;
+    char shm_name[64];
+    float *columns;             // per-pixel-column scratch, width entries
+    int *heights;
+} kitty_ctx_t;
+
+bool kitty_detect(void);
+int kitty_init(kitty_ctx_t *ctx);
+void kitty_shutdown(kitty_ctx_t *ctx);
+// Cover cols x rows cells starting at top_row. Returns 1 when the image was
+// (re)created and needs a full commit, 0 if unchanged, -1 if the terminal
+// does not report its pixel size
+int kitty_configure(kitty_ctx_t *ctx, int top_row, int cols, int rows, kitty_image_t content);
+// Buffer for nrows full-width RGBA rows, valid until the next commit
+uint8_t *kitty_begin(kitty_ctx_t *ctx, int nrows);
+// Send a complete image (nrows == height) and place it; for the waterfall
+// the top row becomes the newest line
+int kitty_commit_image(kitty_ctx_t *ctx);
+// Push the prepared row as the newest waterfall line and scroll
+int kitty_commit_waterfall_row(kitty_ctx_t *ctx);
+void kitty_clear(kitty_ctx_t *ctx);
+
+#endif
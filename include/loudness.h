@@ -0,0 +1,84 @@
+#ifndef LOUDNESS_H
+#define LOUDNESS_H
+
+#include "audio.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+constexpr size_t LOUDNESS_LANES = 8;            // channels processed per vector step
+constexpr size_t LOUDNESS_CHUNK = 1024;         // frames pulled from the capture ring at once
+constexpr int LOUDNESS_SHORT_BLOCKS = 30;       // 3 s short-term window in 100 ms blocks
+constexpr int LOUDNESS_MOMENTARY_BLOCKS = 4;    // 400 ms momentary window
+constexpr int LOUDNESS_HIST_BINS = 751;         // -70..+5 LUFS in 0.1 LU steps
+constexpr int LOUDNESS_TP_PHASES = 4;           // true-peak oversampling factor
+constexpr int LOUDNESS_TP_TAPS = 12;            // FIR taps per polyphase branch
+
+typedef double loudness_vec_t __attribute__((vector_size(LOUDNESS_LANES * sizeof(double))));
+
+// One snapshot of the meter, all levels in LUFS / LU / dBTP
+typedef struct {
+    double momentary;
+    double short_term;
+    double integrated;
+    double range;               // loudness range (LRA)
+    double true_peak;           // max over the last momentary window
+    double true_peak_max;       // max since reset
+} loudness_reading_t;
+
+// Streaming ITU-R BS.1770-4 / EBU R128 meter. Runs on its own thread while
+// the meter is shown and consumes every captured sample from the audio ring;
+// K-weighting and the true-peak interpolator run across all channels at
+// once, one lane each.
+typedef struct {
+    audio_ctx_t *audio;
+    pthread_t thread;
+    atomic_bool running;
+    atomic_bool reset_requested;
+    uint64_t cursor;            // next capture frame to consume
+
+    uint32_t sample_rate;
+    uint32_t channels;
+    loudness_vec_t weight;      // BS.1770 channel weights (0 for LFE and unused lanes)
+
+    // K-weighting: high shelf followed by RLB high-pass, transposed DF-II
+    double shelf_b[3], shelf_a[3];
+    double hp_b[3], hp_a[3];
+    loudness_vec_t shelf_z1, shelf_z2;
+    loudness_vec_t hp_z1, hp_z2;
+
+    // 100 ms blocks of channel-weighted mean square
+    loudness_vec_t block_sum;
+    uint32_t block_len;         // frames per 100 ms block
+    uint32_t block_fill;
+    double blocks[LOUDNESS_SHORT_BLOCKS];
+    int block_pos;
+    int block_count;
+
+    // Gating histograms of 400 ms (integrated) and 3 s (LRA) loudness
+    uint32_t hist_integrated[LOUDNESS_HIST_BINS];
+    uint32_t hist_range[LOUDNESS_HIST_BINS];
+    double hist_energy[LOUDNESS_HIST_BINS];
+
+    // True peak: polyphase interpolator with a doubled history ring
+    double tp_coeffs[LOUDNESS_TP_PHASES][LOUDNESS_TP_TAPS];
+    loudness_vec_t tp_history[2 * LOUDNESS_TP_TAPS];
+    int tp_pos;
+    loudness_vec_t tp_block_max;
+    double tp_blocks[LOUDNESS_MOMENTARY_BLOCKS];
+    int tp_block_pos;           // own ring position; block_pos wraps at 30
+
+    pthread_mutex_t lock;       // guards reading
+    loudness_reading_t reading;
+
+    float *scratch[AUDIO_MAX_CHANNELS];
+} loudness_ctx_t;
+
+int loudness_init(loudness_ctx_t *ctx, audio_ctx_t *audio);
+void loudness_shutdown(loudness_ctx_t *ctx);
+void loudness_read(loudness_ctx_t *ctx, loudness_reading_t *reading);
+void loudness_reset(loudness_ctx_t *ctx);
+
+#endif
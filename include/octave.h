@@ -0,0 +1,87 @@
+#ifndef OCTAVE_H
+#define OCTAVE_H
+
+#include "audio.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+constexpr int OCTAVE_MAX_BANDS = 64;        // 1/6 octave over 20 Hz .. 20 kHz is 60
+constexpr int OCTAVE_MAX_STAGES = 10;       // each stage runs at half the rate of the one above
+constexpr int OCTAVE_SECTIONS = 3;          // 6th-order Butterworth band-pass as 3 biquads
+constexpr int OCTAVE_HALFBAND_TAPS = 31;
+constexpr double OCTAVE_STAGE_PASS = 0.2;   // band upper edge limit, fraction of a stage's rate
+constexpr double OCTAVE_LOW_HZ = 20.0;      // lowest band centre
+constexpr double OCTAVE_HIGH_HZ = 20000.0;  // highest band centre
+constexpr double OCTAVE_FAST_TAU = 0.125;   // IEC 61672 time constants
+constexpr double OCTAVE_SLOW_TAU = 1.0;
+constexpr size_t OCTAVE_CHUNK = 1024;       // frames pulled from the capture ring at once
+
+typedef enum {
+    OCTAVE_FAST,
+    OCTAVE_SLOW,
+    OCTAVE_LEQ,                 // energy mean since start or reset
+    OCTAVE_WEIGHTINGS
+} octave_weighting_t;
+
+typedef struct {
+    double b0, b1, b2, a1, a2;
+    double z1, z2;              // transposed direct form II state
+} octave_biquad_t;
+
+typedef struct {
+    double centre;              // exact IEC 61260 mid-band frequency
+    int stage;                  // decimation stage the filter runs at
+    octave_biquad_t sections[OCTAVE_SECTIONS];
+    double fast, slow;          // time-weighted mean square
+    double sum;                 // Leq accumulation
+    uint64_t count;
+} octave_band_t;
+
+typedef struct {
+    double history[2 * OCTAVE_HALFBAND_TAPS];   // doubled ring
+    int pos;
+    bool odd;                   // every other input produces an output
+} octave_decimator_t;
+
+// IEC 61260 fractional-octave analyzer. Every captured sample (channel mean)
+// runs through a cascade of half-band decimators; each band-pass filter runs
+// at the lowest rate that still holds its band, so the low octaves cost a
+// fraction of the top one. Runs on its own thread like the loudness meter.
+typedef struct {
+    audio_ctx_t *audio;
+    pthread_t thread;
+    atomic_bool running;
+    atomic_bool reset_requested;
+    uint64_t cursor;
+
+    uint32_t sample_rate;
+    uint32_t channels;
+    int fraction;               // 1, 3 or 6 bands per octave
+    int num_bands;
+    int num_stages;
+    octave_band_t bands[OCTAVE_MAX_BANDS];
+    octave_decimator_t decimators[OCTAVE_MAX_STAGES];
+    double halfband[OCTAVE_HALFBAND_TAPS];
+    double fast_coeff[OCTAVE_MAX_STAGES];
+    double slow_coeff[OCTAVE_MAX_STAGES];
+    double *stage_buf[OCTAVE_MAX_STAGES];       // this chunk at each stage's rate
+    float *scratch[AUDIO_MAX_CHANNELS];
+
+    pthread_mutex_t lock;       // guards levels and centres
+    double levels[OCTAVE_WEIGHTINGS][OCTAVE_MAX_BANDS];    // dB, 0 = full-scale sine
+    double centres[OCTAVE_MAX_BANDS];
+    int published_bands;
+} octave_ctx_t;
+
+int octave_init(octave_ctx_t *ctx, audio_ctx_t *audio, int fraction);
+void octave_shutdown(octave_ctx_t *ctx);
+// Copy the latest band levels; returns the number of bands
+int octave_read(octave_ctx_t *ctx, octave_weighting_t weighting, double *levels, double *centres);
+void octave_reset(octave_ctx_t *ctx);
+// Nominal band name ("31.5", "1k", "12.5k") for a mid-band frequency
+void octave_band_label(double centre, int fraction, char *buf, size_t size);
+
+#endif
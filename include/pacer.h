@@ -0,0 +1,28 @@
+#ifndef PACER_H
+#define PACER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+constexpr double PACER_ACTIVE_FPS = 60.0;
+constexpr double PACER_IDLE_FPS = 4.0;
+constexpr double PACER_MIN_FPS = 10.0;           // floor under terminal backpressure
+constexpr double PACER_BUSY_FRACTION = 0.5;      // render time budget before backing off
+constexpr size_t PACER_OUTQ_LIMIT = 16384;       // queued tty bytes before backing off
+
+typedef struct {
+    double fps;                 // current active rate, lowered by backpressure
+    double next_frame;          // monotonic deadline of the next frame (seconds)
+    double last_frame;          // monotonic time of the previous frame
+    double frame_dt;            // elapsed seconds between the last two frames
+    bool idle;                  // input silent and display settled
+} pacer_ctx_t;
+
+void pacer_init(pacer_ctx_t *ctx);
+double pacer_now(void);
+int pacer_timeout_ms(const pacer_ctx_t *ctx);
+void pacer_begin_frame(pacer_ctx_t *ctx);
+void pacer_end_frame(pacer_ctx_t *ctx, double render_seconds);
+void pacer_set_idle(pacer_ctx_t *ctx, bool idle);
+
+#endif
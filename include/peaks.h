@@ -0,0 +1,36 @@
+#ifndef PEAKS_H
+#define PEAKS_H
+
+#include <stddef.h>
+
+constexpr size_t PEAKS_LANES = 8;       // floats per SIMD step
+constexpr size_t PEAKS_ALIGN = 64;
+
+// Peak-hold state as structure-of-arrays, updated with elapsed time rather
+// than frame counts. Arrays are PEAKS_ALIGN-aligned and padded to a
+// multiple of PEAKS_LANES so the update runs without a scalar tail.
+// Rows for several channels or sources can share one state by laying
+// their levels out back to back.
+typedef struct {
+    float *value;           // held peak level (same units as the input)
+    float *hold_until;      // release deadline, seconds relative to epoch
+    size_t count;           // elements in use
+    size_t capacity;        // elements allocated (multiple of PEAKS_LANES)
+    double epoch;           // time base keeping deadlines within float precision
+} peaks_t;
+
+int peaks_init(peaks_t *peaks, size_t capacity, double now);
+void peaks_shutdown(peaks_t *peaks);
+void peaks_reset(peaks_t *peaks, size_t count);
+// Grow the arrays to hold capacity elements, keeping the state
+int peaks_reserve(peaks_t *peaks, size_t capacity);
+// Resample the held peaks onto count elements spanning the same axis;
+// shrinking keeps the highest peak of each merged span
+void peaks_remap(peaks_t *peaks, size_t count);
+float *peaks_alloc_levels(size_t capacity);
+// levels must be padded to peaks->capacity; attack and release are in
+// level units per second (attack <= 0 means instant)
+void peaks_update(peaks_t *peaks, const float *levels, double now, double dt,
+                  double hold, double attack, double release);
+
+#endif
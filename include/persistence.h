@@ -0,0 +1,37 @@
+#ifndef PERSISTENCE_H
+#define PERSISTENCE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+constexpr int PERSISTENCE_LEVELS = 128;         // level rows over the normalized 0..1 range
+constexpr size_t PERSISTENCE_HOP = 512;         // STFT hop in frames (75% overlap at FFT_SIZE)
+constexpr double PERSISTENCE_TIME = 1.0;        // default decay time constant in seconds
+constexpr double PERSISTENCE_RESCALE = 1 << 20; // hit weight that triggers a counter rescale
+constexpr int PERSISTENCE_SHIFT = 8;            // bits dropped from every counter on rescale
+constexpr double PERSISTENCE_MAX_FRAMES = 2048; // frames per time constant that fit in 32 bits
+
+// Decaying (frequency bin x level) hit histogram. Instead of multiplying
+// every counter by the decay factor each frame, each new hit is weighted
+// by a growing factor; counters are shifted down together only when that
+// weight gets large, so a frame costs one increment per bin.
+typedef struct {
+    uint32_t *counts;           // [bins][PERSISTENCE_LEVELS]
+    size_t bins;
+    double weight;              // weight of the next frame's hits
+    double growth;              // per-frame weight growth, 1 / decay factor
+    double frame_rate;          // STFT frames per second
+    double time;                // decay time constant in seconds
+} persistence_t;
+
+int persistence_init(persistence_t *p, size_t bins);
+void persistence_shutdown(persistence_t *p);
+void persistence_clear(persistence_t *p);
+void persistence_set_decay(persistence_t *p, double frame_rate, double time);
+// Count one frame of normalized (0..1) levels
+void persistence_add(persistence_t *p, const double *spectrum);
+// Hit density per level (1 = hit every frame) over bins [first, last),
+// taking the densest bin at each level
+void persistence_column(const persistence_t *p, size_t first, size_t last, float *levels);
+
+#endif
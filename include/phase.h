@@ -0,0 +1,44 @@
+#ifndef PHASE_H
+#define PHASE_H
+
+#include "spectrum.h"
+#include <stddef.h>
+
+constexpr int PHASE_BANDS = 10;                 // octave bands centred 31.5 Hz .. 16 kHz
+constexpr double PHASE_AVERAGING_TIME = 0.16;   // time constant of the averaged cross-spectra, seconds
+constexpr double PHASE_CORRELATION_TIME = 0.075;
+constexpr double PHASE_SCOPE_DECAY_TIME = 0.06; // fade of the vectorscope trace
+
+// Stereo phase analysis built from data the analyzer already has: the
+// stats sums for correlation, the per-channel transforms for per-band
+// coherence, and the same samples for the vectorscope. All three are fed
+// once per analysis hop and smoothed with time constants, so they read the
+// same at any redraw rate.
+typedef struct {
+    double correlation;         // smoothed Pearson correlation of L and R, -1..+1
+
+    // Exponentially averaged auto/cross spectra summed per octave band
+    double sxx[PHASE_BANDS];
+    double syy[PHASE_BANDS];
+    double sxy_re[PHASE_BANDS];
+    double sxy_im[PHASE_BANDS];
+    double coherence[PHASE_BANDS];  // magnitude-squared coherence, 0..1
+    double phase[PHASE_BANDS];      // mean phase of R relative to L in degrees
+
+    // Vectorscope dot intensities, [dots_h][dots_w], mid up and side across
+    float *scope;
+    int dots_w, dots_h;
+} phase_ctx_t;
+
+void phase_shutdown(phase_ctx_t *p);
+void phase_reset(phase_ctx_t *p);
+double phase_band_center(int band);
+// Each update covers seconds of new audio
+void phase_update_correlation(phase_ctx_t *p, double sum_lr, double sum_ll, double sum_rr, double seconds);
+void phase_update_bands(phase_ctx_t *p, const fftw_complex *left, const fftw_complex *right,
+                        size_t bins, int sample_rate, double seconds);
+// Fade the trace and plot count L/R sample pairs scaled by gain
+int phase_update_scope(phase_ctx_t *p, const float *left, const float *right, size_t count,
+                       int dots_w, int dots_h, double gain, double seconds);
+
+#endif
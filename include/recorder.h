@@ -0,0 +1,62 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include "audio.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+constexpr size_t RECORDER_CHUNK = 4096;             // frames drained from the capture ring at once
+constexpr size_t RECORDER_FILE_BUFFER = 1 << 20;    // stdio buffer, so the disk sees large writes
+constexpr size_t RECORDER_LABEL_LEN = 32;
+constexpr size_t RECORDER_PATH_LEN = 512;
+constexpr double RECORDER_SLACK_SECONDS = 1.0;      // extra history covering trigger latency
+constexpr double RECORDER_MAX_SECONDS = 300.0;      // retriggers stop extending a capture here
+constexpr double RECORDER_POLL_SECONDS = 0.02;
+
+// Triggered capture to 32-bit float WAV. A writer thread drains the
+// capture ring into its own interleaved history of the last pre-trigger
+// seconds; a trigger writes that history followed by the post-trigger
+// audio. All file I/O happens on the writer thread.
+typedef struct {
+    audio_ctx_t *audio;
+    pthread_t thread;
+    atomic_bool running;
+    atomic_bool recording;
+    atomic_uint captures;       // files completed
+    uint64_t cursor;            // next capture frame to drain
+    const char *directory;
+    double pre_seconds;
+    double post_seconds;
+
+    // Writer-thread state
+    uint32_t sample_rate;
+    uint32_t channels;
+    float *ring;                // interleaved [ring_frames][channels]
+    size_t ring_frames;
+    uint64_t ring_first;        // oldest frame ever stored since configuration
+    float *scratch[AUDIO_MAX_CHANNELS];
+    float *interleaved;         // one drained chunk, interleaved
+    FILE *file;
+    uint64_t start_frame;       // trigger frame of the open capture
+    uint64_t write_pos;         // next frame to write
+    uint64_t end_frame;         // first frame past the post-trigger span
+    uint64_t data_frames;
+    char path[RECORDER_PATH_LEN];
+
+    pthread_mutex_t lock;       // guards the pending trigger
+    bool pending;
+    uint64_t pending_frame;
+    char pending_label[RECORDER_LABEL_LEN];
+} recorder_ctx_t;
+
+int recorder_init(recorder_ctx_t *ctx, audio_ctx_t *audio, const char *directory,
+                  double pre_seconds, double post_seconds);
+void recorder_shutdown(recorder_ctx_t *ctx);
+// Request a capture around the given absolute capture frame
+void recorder_trigger(recorder_ctx_t *ctx, uint64_t frame, const char *label);
+bool recorder_active(recorder_ctx_t *ctx);
+
+#endif
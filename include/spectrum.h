@@ -6,19 +6,65 @@
 
 constexpr size_t FFT_SIZE = 2048;
 constexpr size_t SPECTRUM_BINS = FFT_SIZE / 2;
+constexpr size_t SPECTRUM_MAX_CHANNELS = 8;
+constexpr size_t SPECTRUM_AVG_MAX_FRAMES = 128;  // longest linear average
+constexpr double SPECTRUM_DB_RANGE = 80.0;  // dB below full scale mapped to levels 0..1
+constexpr double SPECTRUM_AVG_STEP_SECONDS = 1.0 / 60.0;  // audio over which smoothing is the kept weight
+// Complex outputs per channel, padded to a 64-byte multiple so every
+// channel's transform starts on a cache line
+constexpr size_t SPECTRUM_OUT_STRIDE = (FFT_SIZE / 2 + 1 + 3) & ~(size_t)3;
+// Batched transforms at least this large (samples across all channels)
+// are planned with FFTW threads when available
+constexpr size_t SPECTRUM_THREADS_MIN_SIZE = 16384;
+
+// Temporal processing of the displayed spectrum; all averaging is done on
+// power so levels stay unbiased
+typedef enum {
+    SPECTRUM_AVG_EXP,           // exponential power average, factor = smoothing per step
+    SPECTRUM_AVG_LINEAR,        // mean power of the last N frames (Welch)
+    SPECTRUM_AVG_MAX,           // max hold until reset
+    SPECTRUM_AVG_MIN,           // min hold until reset
+    SPECTRUM_AVG_COUNT
+} spectrum_average_t;
 
 typedef struct {
-    double *input;
-    fftw_complex *output;
-    fftw_plan plan;
-    double *magnitudes;
-    double *smoothed;
+    double *input;              // channel-major [channels][FFT_SIZE]
+    fftw_complex *output;       // channel-major [channels][SPECTRUM_OUT_STRIDE]
+    fftw_complex *mix;          // sum of channel spectra for the mix view
+    fftw_plan plan;             // one batched r2c plan over all channels
+    double *window;             // cached Hann window
+    size_t window_len;
+    double *magnitudes;         // [channels + 1][SPECTRUM_BINS], view 0 = mix
+    double *power;              // this frame's power, same layout
+    double *average;            // exp/max/min state or linear running sum, same layout
+    double *averaged;           // displayed levels, same layout
+    float *ring;                // linear: [SPECTRUM_AVG_MAX_FRAMES][channels + 1][SPECTRUM_BINS]
+    size_t ring_frames;         // linear: frames averaged
+    size_t ring_pos;
+    size_t ring_count;
+    size_t frames;              // frames folded into average since reset
+    spectrum_average_t mode;
     double smoothing;
+    size_t channels;
 } spectrum_ctx_t;
 
-int spectrum_init(spectrum_ctx_t *ctx);
+int spectrum_init(spectrum_ctx_t *ctx, size_t channels);
 void spectrum_shutdown(spectrum_ctx_t *ctx);
-void spectrum_process(spectrum_ctx_t *ctx, const float *samples, size_t count);
+// One transform of the latest samples into the unsmoothed levels
+void spectrum_analyze(spectrum_ctx_t *ctx, const float *const *samples, size_t count);
+// spectrum_analyze followed by the averaging step; seconds is the audio
+// captured since the previous call, so the exponential average keeps its
+// time constant whatever the call rate
+void spectrum_process(spectrum_ctx_t *ctx, const float *const *samples, size_t count, double seconds);
+// Also sets the linear average length, N = (1 + s) / (1 - s) frames
 void spectrum_set_smoothing(spectrum_ctx_t *ctx, double smoothing);
+int spectrum_set_average(spectrum_ctx_t *ctx, spectrum_average_t mode);
+void spectrum_reset_average(spectrum_ctx_t *ctx);
+const char *spectrum_average_name(spectrum_average_t mode);
+const double *spectrum_view(const spectrum_ctx_t *ctx, size_t view);
+// Complex transform of one channel from the last spectrum_analyze
+const fftw_complex *spectrum_channel_bins(const spectrum_ctx_t *ctx, size_t channel);
+// Unsmoothed levels of the last spectrum_analyze
+const double *spectrum_levels(const spectrum_ctx_t *ctx, size_t view);
 
 #endif
@@ -0,0 +1,45 @@
+#ifndef TONAL_H
+#define TONAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+constexpr int TONAL_MAX_PEAKS = 32;         // strongest candidates kept per frame
+constexpr int TONAL_MAX_TRACKS = 32;
+constexpr int TONAL_TOP = 5;                // peaks shown in the overlay
+constexpr int TONAL_MIN_AGE = 3;            // frames before a track is reported
+constexpr int TONAL_MAX_MISSED = 8;         // frames a track survives without a match
+constexpr double TONAL_MIN_SNR = 12.0;      // dB above the noise floor
+constexpr double TONAL_HANN_GAIN_DB = 12.04;    // sine peak vs bin level for a Hann window
+constexpr double TONAL_TRACK_BINS = 1.5;    // match distance in bins
+constexpr double TONAL_FREQ_SMOOTHING = 0.7;
+
+typedef struct {
+    double freq;                // Hz, sub-bin interpolated
+    double dbfs;                // sine amplitude estimate
+} tonal_peak_t;
+
+typedef struct {
+    double freq;
+    double dbfs;
+    int age;                    // frames matched
+    int missed;                 // consecutive frames unmatched
+    bool active;
+} tonal_track_t;
+
+// Tonal peak tracker over normalized levels (0..1 over SPECTRUM_DB_RANGE)
+typedef struct {
+    tonal_peak_t peaks[TONAL_MAX_PEAKS];
+    int num_peaks;
+    tonal_track_t tracks[TONAL_MAX_TRACKS];
+    tonal_peak_t top[TONAL_TOP];    // strongest established tracks, loudest first
+    int num_top;
+    double floor_db;            // median level of the last frame, dBFS
+} tonal_ctx_t;
+
+void tonal_reset(tonal_ctx_t *ctx);
+void tonal_update(tonal_ctx_t *ctx, const double *levels, size_t bins, int sample_rate);
+// "A4 +3c" style name of the nearest equal-tempered note
+void tonal_note_name(double freq, char *buf, size_t size);
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef TRIGGER_H
+#define TRIGGER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+constexpr int TRIGGER_MAX_RULES = 8;
+constexpr size_t TRIGGER_NAME_LEN = 32;
+constexpr double TRIGGER_REARM_DB = 3.0;        // hysteresis below the threshold
+constexpr double TRIGGER_HOLD_SECONDS = 0.05;   // level must stay below that long, about one window
+
+typedef enum {
+    TRIGGER_LEVEL,      // sample peak over threshold dBFS
+    TRIGGER_BAND,       // summed bin power between two frequencies over threshold dB
+    TRIGGER_FLUX        // mean per-bin level rise since the last hop over threshold dB
+} trigger_kind_t;
+
+typedef struct {
+    trigger_kind_t kind;
+    double threshold;
+    double low_hz, high_hz;     // TRIGGER_BAND only
+    char name[TRIGGER_NAME_LEN];    // rule as given, used in file names
+    double rearm;               // value the rule must fall to before it can fire again
+    bool armed;
+    size_t quiet;               // TRIGGER_LEVEL: consecutive frames at or below rearm
+} trigger_rule_t;
+
+// Level rules scan every captured frame; band and flux rules are evaluated
+// on the unsmoothed normalized spectrum of every analysis hop. Each rule
+// fires once and then stays quiet until its value has dropped back below
+// the re-arm level, so a sustained condition yields one capture. Rules are
+// independent: every rule that fires is reported.
+typedef struct {
+    trigger_rule_t rules[TRIGGER_MAX_RULES];
+    int count;
+    bool spectral;              // any band or flux rule, which need a transform per hop
+    double *previous;           // last frame's levels, for flux
+    size_t bins;
+    bool has_previous;
+} trigger_ctx_t;
+
+// Parse "level:DBFS", "band:LO-HI:DB" or "flux:DB"; -1 on bad syntax
+int trigger_add_rule(trigger_ctx_t *ctx, const char *spec);
+void trigger_shutdown(trigger_ctx_t *ctx);
+// Run the level rules over count consecutive planar frames. Returns the
+// rules that fired as a mask (bit r for rule r) and the frame offset of the
+// first firing in *offset
+unsigned trigger_scan(trigger_ctx_t *ctx, const float *const *samples, size_t channels, size_t count,
+                      int sample_rate, size_t *offset);
+// Run the band and flux rules on one hop's spectrum; mask of the rules that fired
+unsigned trigger_eval(trigger_ctx_t *ctx, const double *spectrum, size_t bins, int sample_rate);
+// Names of the rules in a fired mask joined with '+', for the capture label
+void trigger_label(const trigger_ctx_t *ctx, unsigned fired, char *buf, size_t size);
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef TSPEC_H
+#define TSPEC_H
+
+// Embeddable analyzer core. Everything is reached through opaque handles;
+// all memory is allocated by tspec_create / tspec_capture_open and the
+// processing calls write only into caller-supplied buffers. Handles are
+// independent of each other and may live on different threads, but one
+// handle must not be used from two threads at once.
+
+// Unlike the internal headers this one sticks to C99 and C++ so that any
+// consumer can include it.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TSPEC_FFT_SIZE 2048             // frames per analysis window
+#define TSPEC_BINS (TSPEC_FFT_SIZE / 2)
+#define TSPEC_MAX_CHANNELS 8
+#define TSPEC_DB_RANGE 80.0             // levels 0..1 span this many dB below full scale
+
+typedef struct tspec tspec_t;
+typedef struct tspec_capture tspec_capture_t;
+
+typedef enum {
+    TSPEC_AVG_EXP,              // exponential power average
+    TSPEC_AVG_LINEAR,           // mean power of the last (1 + s) / (1 - s) frames
+    TSPEC_AVG_MAX,              // max hold until reset
+    TSPEC_AVG_MIN,              // min hold until reset
+} tspec_average_t;
+
+typedef struct {
+    uint32_t channels;          // 1 .. TSPEC_MAX_CHANNELS
+    uint32_t sample_rate;       // Hz, used for band mapping and averaging time
+    double smoothing;           // 0 .. 0.99, exp weight kept per 1/60 s of audio
+    tspec_average_t average;    // fixed for the life of the handle
+} tspec_config_t;
+
+typedef struct {
+    double peak;                // max |sample| over all channels
+    double rms[TSPEC_MAX_CHANNELS];
+    double correlation;         // channels 0 and 1, -1 .. +1 (0 for mono)
+} tspec_stats_t;
+
+tspec_t *tspec_create(const tspec_config_t *config);
+void tspec_destroy(tspec_t *t);
+// Analyze 2 .. TSPEC_FFT_SIZE frames of planar samples (shorter blocks
+// are zero padded) and fold them into the average as count new frames;
+// -1 for fewer than 2
+int tspec_process(tspec_t *t, const float *const *samples, size_t count);
+void tspec_set_smoothing(tspec_t *t, double smoothing);
+void tspec_reset(tspec_t *t);
+// Averaged levels (0..1) of a view, 0 = mix, N = channel N; returns bins written
+size_t tspec_levels(const tspec_t *t, size_t view, double *out, size_t max);
+// Levels sampled at n octave-spaced columns from 20 Hz to Nyquist
+int tspec_bands(const tspec_t *t, size_t view, float *out, int n);
+// Peak, RMS and correlation of one planar block; needs no handle
+void tspec_stats(const float *const *samples, uint32_t channels, size_t count, tspec_stats_t *out);
+
+// PipeWire monitor capture of the default sink into a planar ring
+tspec_capture_t *tspec_capture_open(const char *client_name);
+void tspec_capture_close(tspec_capture_t *capture);
+// Copy up to max frames after *cursor (absolute frame count) and advance it.
+// dest must hold TSPEC_MAX_CHANNELS rows of max floats: one row is written
+// per capture channel, and the channel count can change when the sink
+// renegotiates its format
+size_t tspec_capture_read(tspec_capture_t *capture, uint64_t *cursor, float *const *dest, size_t max);
+uint64_t tspec_capture_position(tspec_capture_t *capture);
+uint32_t tspec_capture_rate(tspec_capture_t *capture);
+uint32_t tspec_capture_channels(tspec_capture_t *capture);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,8 +1,36 @@
 #include "audio.h"
 #include <pipewire/pipewire.h>
 #include <spa/param/audio/format-utils.h>
+#include <spa/param/audio/type-info.h>
+#include <spa/debug/types.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+// pw_init/pw_deinit are process-wide; count users so several capture
+// contexts (or an embedding application) can come and go independently
+static pthread_mutex_t pw_lock = PTHREAD_MUTEX_INITIALIZER;
+static int pw_users;
+
+static void pw_acquire(void) {
+    pthread_mutex_lock(&pw_lock);
+    if (pw_users++ == 0) {
+        pw_init(NULL, NULL);
+    }
+    pthread_mutex_unlock(&pw_lock);
+}
+
+static void pw_release(void) {
+    pthread_mutex_lock(&pw_lock);
+    if (--pw_users == 0) {
+        pw_deinit();
+    }
+    pthread_mutex_unlock(&pw_lock);
+}
 
 static void on_process(void *userdata) {
     audio_ctx_t *ctx = userdata;
@@ -14,20 +42,49 @@ static void on_process(void *userdata) {
     }
 
     buf = b->buffer;
-    float *samples = buf->datas[0].data;
+    const uint8_t *samples = buf->datas[0].data;
 
     if (samples == NULL) {
         pw_stream_queue_buffer(ctx->stream, b);
         return;
     }
 
-    // Stereo interleaved: L,R,L,R... so divide by 2 for frame count
-    uint32_t n_frames = buf->datas[0].chunk->size / sizeof(float) / 2;
+    // Interleaved: one sample per stream channel per frame; channels beyond
+    // AUDIO_MAX_CHANNELS are dropped. Convert straight into the planar ring
+    // as at most two contiguous spans around the wrap.
+    convert_format_t format = ctx->format;
+    uint32_t stride = ctx->stream_channels;
+    uint32_t channels = ctx->channels;
+    size_t frame_bytes = convert_sample_size(format) * stride;
+    uint32_t n_frames = buf->datas[0].chunk->size / frame_bytes;
+    if (n_frames > AUDIO_BUFFER_SIZE) n_frames = AUDIO_BUFFER_SIZE;
+
+    uint64_t written = atomic_load_explicit(&ctx->frames_written, memory_order_relaxed);
+    size_t pos = written & (AUDIO_BUFFER_SIZE - 1);
+    size_t first = AUDIO_BUFFER_SIZE - pos;
+    if (first > n_frames) first = n_frames;
+    convert_deinterleave(format, samples, stride, channels, ctx->buffer, pos, first);
+    convert_deinterleave(format, samples + first * frame_bytes, stride, channels, ctx->buffer, 0,
+                         n_frames - first);
+    // Publish the frames to readers on other threads
+    atomic_store_explicit(&ctx->frames_written, written + n_frames, memory_order_release);
 
-    for (uint32_t i = 0; i < n_frames; i++) {
-        ctx->buffer_l[ctx->write_pos] = samples[i * 2];
-        ctx->buffer_r[ctx->write_pos] = samples[i * 2 + 1];
-        ctx->write_pos = (ctx->write_pos + 1) % AUDIO_BUFFER_SIZE;
+    // While the reader idles, wake it on the first block above the silence
+    // floor; the peak scan only runs while armed
+    if (atomic_load_explicit(&ctx->wake_armed, memory_order_relaxed)) {
+        float peak = 0.0f;
+        for (uint32_t c = 0; c < channels; c++) {
+            for (size_t i = 0; i < n_frames; i++) {
+                float v = fabsf(ctx->buffer[c][(written + i) & (AUDIO_BUFFER_SIZE - 1)]);
+                if (v > peak) peak = v;
+            }
+        }
+        if (peak > AUDIO_WAKE_LEVEL && atomic_exchange(&ctx->wake_armed, false)) {
+            uint64_t one = 1;
+            if (write(ctx->wake_fd, &one, sizeof(one)) < 0) {
+                // counter saturated; the reader is already awake
+            }
+        }
     }
 
     pw_stream_queue_buffer(ctx->stream, b);
@@ -42,6 +99,29 @@ static void on_stream_param_changed(void *userdata, uint32_t id, const struct sp
     struct spa_audio_info_raw info;
     if (spa_format_audio_raw_parse(param, &info) >= 0) {
         ctx->sample_rate = info.rate;
+        switch (info.format) {
+            case SPA_AUDIO_FORMAT_S16: ctx->format = CONVERT_S16; break;
+            case SPA_AUDIO_FORMAT_S24: ctx->format = CONVERT_S24; break;
+            case SPA_AUDIO_FORMAT_S32: ctx->format = CONVERT_S32; break;
+            default: ctx->format = CONVERT_F32; break;
+        }
+
+        if (info.channels > 0) {
+            uint32_t channels = info.channels < AUDIO_MAX_CHANNELS ? info.channels : AUDIO_MAX_CHANNELS;
+            for (uint32_t c = 0; c < channels; c++) {
+                const char *name = spa_debug_type_find_short_name(spa_type_audio_channel, info.position[c]);
+                if (name && strcmp(name, "UNK") != 0 && strcmp(name, "NA") != 0) {
+                    snprintf(ctx->channel_names[c], AUDIO_CHANNEL_NAME_LEN, "%s", name);
+                } else {
+                    snprintf(ctx->channel_names[c], AUDIO_CHANNEL_NAME_LEN, "CH%u", c + 1);
+                }
+            }
+            ctx->stream_channels = info.channels;
+            ctx->channels = channels;
+            ctx->stereo = channels >= 2;
+        }
+        ctx->format_known = true;
+        pw_thread_loop_signal(ctx->loop, false);
     }
 }
 
@@ -67,9 +147,32 @@ static const struct pw_stream_events stream_events = {
 
 int audio_init(audio_ctx_t *ctx, const char *client_name) {
     memset(ctx, 0, sizeof(*ctx));
+    ctx->wake_fd = -1;  // before any early return, so shutdown never closes fd 0
     ctx->sample_rate = 48000;  // Default, will be updated when stream connects
+    ctx->channels = 2;
+    ctx->stream_channels = 2;
+    ctx->format = CONVERT_F32;
+    snprintf(ctx->channel_names[0], AUDIO_CHANNEL_NAME_LEN, "FL");
+    snprintf(ctx->channel_names[1], AUDIO_CHANNEL_NAME_LEN, "FR");
+    atomic_init(&ctx->wake_armed, false);
+    atomic_init(&ctx->frames_written, 0);
 
-    pw_init(NULL, NULL);
+    for (size_t c = 0; c < AUDIO_MAX_CHANNELS; c++) {
+        ctx->buffer[c] = calloc(AUDIO_BUFFER_SIZE, sizeof(float));
+        if (!ctx->buffer[c]) {
+            fprintf(stderr, "Failed to allocate capture ring\n");
+            return -1;
+        }
+    }
+
+    ctx->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (ctx->wake_fd < 0) {
+        fprintf(stderr, "Failed to create wake eventfd\n");
+        return -1;
+    }
+
+    pw_acquire();
+    ctx->pw_held = true;
 
     ctx->loop = pw_thread_loop_new(client_name, NULL);
     if (!ctx->loop) {
@@ -95,20 +198,25 @@ int audio_init(audio_ctx_t *ctx, const char *client_name) {
 
     if (!ctx->stream) {
         fprintf(stderr, "Failed to create PipeWire stream\n");
-        pw_thread_loop_destroy(ctx->loop);
         return -1;
     }
 
     uint8_t buffer[1024];
     struct spa_pod_builder b = SPA_POD_BUILDER_INIT(buffer, sizeof(buffer));
 
+    // Take the sink's native sample format and channel count; conversion
+    // happens in on_process instead of an extra stage in the graph
     const struct spa_pod *params[1];
-    params[0] = spa_format_audio_raw_build(&b, SPA_PARAM_EnumFormat,
-        &SPA_AUDIO_INFO_RAW_INIT(
-            .format = SPA_AUDIO_FORMAT_F32,
-            .channels = 2,
-            .rate = 0  // Any rate
-        ));
+    params[0] = spa_pod_builder_add_object(&b,
+        SPA_TYPE_OBJECT_Format, SPA_PARAM_EnumFormat,
+        SPA_FORMAT_mediaType, SPA_POD_Id(SPA_MEDIA_TYPE_audio),
+        SPA_FORMAT_mediaSubtype, SPA_POD_Id(SPA_MEDIA_SUBTYPE_raw),
+        SPA_FORMAT_AUDIO_format, SPA_POD_CHOICE_ENUM_Id(5,
+            SPA_AUDIO_FORMAT_F32,   // default
+            SPA_AUDIO_FORMAT_F32,
+            SPA_AUDIO_FORMAT_S32,
+            SPA_AUDIO_FORMAT_S24,
+            SPA_AUDIO_FORMAT_S16));
 
     if (pw_stream_connect(ctx->stream,
                           PW_DIRECTION_INPUT,
@@ -118,15 +226,23 @@ int audio_init(audio_ctx_t *ctx, const char *client_name) {
                           PW_STREAM_FLAG_RT_PROCESS,
                           params, 1) < 0) {
         fprintf(stderr, "Failed to connect PipeWire stream\n");
-        pw_stream_destroy(ctx->stream);
-        pw_thread_loop_destroy(ctx->loop);
         return -1;
     }
 
     pw_thread_loop_start(ctx->loop);
-    ctx->stereo = true;  // PipeWire handles stereo via 2-channel format
+    ctx->stereo = true;
     ctx->running = true;
 
+    // Wait briefly for format negotiation so callers can size per-channel
+    // state; keep the stereo defaults if nothing is connected yet
+    pw_thread_loop_lock(ctx->loop);
+    while (!ctx->format_known) {
+        if (pw_thread_loop_timed_wait(ctx->loop, 1) != 0) {
+            break;
+        }
+    }
+    pw_thread_loop_unlock(ctx->loop);
+
     return 0;
 }
 
@@ -142,26 +258,84 @@ void audio_shutdown(audio_ctx_t *ctx) {
         pw_thread_loop_destroy(ctx->loop);
         ctx->loop = NULL;
     }
-    pw_deinit();
+    if (ctx->wake_fd >= 0) {
+        close(ctx->wake_fd);
+        ctx->wake_fd = -1;
+    }
+    if (ctx->pw_held) {
+        pw_release();
+        ctx->pw_held = false;
+    }
+    for (size_t c = 0; c < AUDIO_MAX_CHANNELS; c++) {
+        free(ctx->buffer[c]);
+        ctx->buffer[c] = NULL;
+    }
     ctx->running = false;
 }
 
-size_t audio_get_samples(audio_ctx_t *ctx, float *dest_l, float *dest_r, size_t count) {
+// Copy frames [start, start + count) as two contiguous spans per channel
+// around the ring wrap
+static void copy_frames(audio_ctx_t *ctx, uint64_t start, float *const *dest, size_t count) {
+    size_t pos = start & (AUDIO_BUFFER_SIZE - 1);
+    size_t first = AUDIO_BUFFER_SIZE - pos;
+    if (first > count) first = count;
+
+    for (uint32_t c = 0; c < ctx->channels; c++) {
+        memcpy(dest[c], &ctx->buffer[c][pos], first * sizeof(float));
+        memcpy(dest[c] + first, ctx->buffer[c], (count - first) * sizeof(float));
+    }
+}
+
+size_t audio_get_samples(audio_ctx_t *ctx, float *const *dest, size_t count) {
     if (count > AUDIO_BUFFER_SIZE) {
         count = AUDIO_BUFFER_SIZE;
     }
 
-    size_t start = (ctx->write_pos + AUDIO_BUFFER_SIZE - count) % AUDIO_BUFFER_SIZE;
+    uint64_t written = atomic_load_explicit(&ctx->frames_written, memory_order_acquire);
+    copy_frames(ctx, written - count, dest, count);
 
-    for (size_t i = 0; i < count; i++) {
-        size_t idx = (start + i) % AUDIO_BUFFER_SIZE;
-        dest_l[i] = ctx->buffer_l[idx];
-        dest_r[i] = ctx->buffer_r[idx];
+    return count;
+}
+
+size_t audio_read(audio_ctx_t *ctx, uint64_t *cursor, float *const *dest, size_t max) {
+    uint64_t written = atomic_load_explicit(&ctx->frames_written, memory_order_acquire);
+
+    // Keep half the ring as margin so the writer can't overtake the copy
+    if (written - *cursor > AUDIO_BUFFER_SIZE / 2) {
+        *cursor = written - AUDIO_BUFFER_SIZE / 2;
     }
+    size_t count = (size_t)(written - *cursor);
+    if (count > max) count = max;
+
+    copy_frames(ctx, *cursor, dest, count);
+    *cursor += count;
 
     return count;
 }
 
+uint64_t audio_frames_written(audio_ctx_t *ctx) {
+    return atomic_load_explicit(&ctx->frames_written, memory_order_acquire);
+}
+
 uint32_t audio_get_sample_rate(audio_ctx_t *ctx) {
     return ctx->sample_rate;
 }
+
+uint32_t audio_get_channels(audio_ctx_t *ctx) {
+    return ctx->channels;
+}
+
+int audio_wake_fd(audio_ctx_t *ctx) {
+    return ctx->wake_fd;
+}
+
+void audio_arm_wake(audio_ctx_t *ctx) {
+    atomic_store_explicit(&ctx->wake_armed, true, memory_order_relaxed);
+}
+
+void audio_ack_wake(audio_ctx_t *ctx) {
+    uint64_t count;
+    atomic_store_explicit(&ctx->wake_armed, false, memory_order_relaxed);
+    while (read(ctx->wake_fd, &count, sizeof(count)) > 0) {
+    }
+}
@@ -0,0 +1,43 @@
+#include "binmap.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+size_t bin_map_column(int col, int n, int sample_rate, size_t spectrum_size) {
+    double max_freq = sample_rate > 0 ? sample_rate / 2.0 : 24000.0;
+    double freq_ratio = max_freq / BIN_MAP_MIN_FREQ;
+    double bin_width = sample_rate > 0 ? (double)sample_rate / (spectrum_size * 2) : 11.7;
+
+    double t = n > 1 ? (double)col / (n - 1) : 0.0;        // 0 to 1
+    double freq = BIN_MAP_MIN_FREQ * pow(freq_ratio, t);    // exponential: octave spacing
+    size_t bin = (size_t)(freq / bin_width);
+    if (bin >= spectrum_size) bin = spectrum_size - 1;
+    if (bin < 1) bin = 1;  // skip DC
+    return bin;
+}
+
+const size_t *bin_map_get(bin_map_t *map, int sample_rate, size_t spectrum_size, int n) {
+    if (map->bins && map->count == n && map->sample_rate == sample_rate &&
+        map->spectrum_size == spectrum_size) {
+        return map->bins;
+    }
+    if (n > map->capacity) {
+        size_t *bins = realloc(map->bins, sizeof(size_t) * n);
+        if (!bins) return NULL;
+        map->bins = bins;
+        map->capacity = n;
+    }
+
+    for (int col = 0; col < n; col++) {
+        map->bins[col] = bin_map_column(col, n, sample_rate, spectrum_size);
+    }
+    map->count = n;
+    map->sample_rate = sample_rate;
+    map->spectrum_size = spectrum_size;
+    return map->bins;
+}
+
+void bin_map_shutdown(bin_map_t *map) {
+    free(map->bins);
+    memset(map, 0, sizeof(*map));
+}
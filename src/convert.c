@@ -0,0 +1,132 @@
+#include "convert.h"
+#include <string.h>
+
+typedef float v8f __attribute__((vector_size(CONVERT_LANES * sizeof(float))));
+typedef float v16f __attribute__((vector_size(2 * CONVERT_LANES * sizeof(float))));
+typedef int32_t v8i __attribute__((vector_size(CONVERT_LANES * sizeof(int32_t))));
+typedef int32_t v16i __attribute__((vector_size(2 * CONVERT_LANES * sizeof(int32_t))));
+typedef int16_t v8s __attribute__((vector_size(CONVERT_LANES * sizeof(int16_t))));
+typedef int16_t v16s __attribute__((vector_size(2 * CONVERT_LANES * sizeof(int16_t))));
+
+constexpr float CONVERT_S16_SCALE = 1.0f / 32768.0f;
+constexpr float CONVERT_S32_SCALE = 1.0f / 2147483648.0f;  // S24 is widened to the top of an int32
+
+#define EVEN_LANES 0, 2, 4, 6, 8, 10, 12, 14
+#define ODD_LANES 1, 3, 5, 7, 9, 11, 13, 15
+
+size_t convert_sample_size(convert_format_t format) {
+    switch (format) {
+        case CONVERT_S16: return 2;
+        case CONVERT_S24: return 3;
+        default: return 4;
+    }
+}
+
+// Stereo fast paths: 8 interleaved frames per step split into the two
+// rows with one shuffle each; return the frames done (the tail is left)
+static size_t stereo_f32(const float *src, float *left, float *right, size_t count) {
+    size_t i = 0;
+    for (; i + CONVERT_LANES <= count; i += CONVERT_LANES) {
+        v16f v;
+        memcpy(&v, src + 2 * i, sizeof(v));
+        v8f l = __builtin_shufflevector(v, v, EVEN_LANES);
+        v8f r = __builtin_shufflevector(v, v, ODD_LANES);
+        memcpy(left + i, &l, sizeof(l));
+        memcpy(right + i, &r, sizeof(r));
+    }
+    return i;
+}
+
+static size_t stereo_s16(const int16_t *src, float *left, float *right, size_t count) {
+    size_t i = 0;
+    for (; i + CONVERT_LANES <= count; i += CONVERT_LANES) {
+        v16s v;
+        memcpy(&v, src + 2 * i, sizeof(v));
+        v8s l = __builtin_shufflevector(v, v, EVEN_LANES);
+        v8s r = __builtin_shufflevector(v, v, ODD_LANES);
+        v8f lf = __builtin_convertvector(l, v8f) * CONVERT_S16_SCALE;
+        v8f rf = __builtin_convertvector(r, v8f) * CONVERT_S16_SCALE;
+        memcpy(left + i, &lf, sizeof(lf));
+        memcpy(right + i, &rf, sizeof(rf));
+    }
+    return i;
+}
+
+static size_t stereo_s32(const int32_t *src, float *left, float *right, size_t count) {
+    size_t i = 0;
+    for (; i + CONVERT_LANES <= count; i += CONVERT_LANES) {
+        v16i v;
+        memcpy(&v, src + 2 * i, sizeof(v));
+        v8i l = __builtin_shufflevector(v, v, EVEN_LANES);
+        v8i r = __builtin_shufflevector(v, v, ODD_LANES);
+        v8f lf = __builtin_convertvector(l, v8f) * CONVERT_S32_SCALE;
+        v8f rf = __builtin_convertvector(r, v8f) * CONVERT_S32_SCALE;
+        memcpy(left + i, &lf, sizeof(lf));
+        memcpy(right + i, &rf, sizeof(rf));
+    }
+    return i;
+}
+
+// Integer sample widened to int32 (S16 stays at its own scale)
+static inline int32_t load_int(convert_format_t format, const uint8_t *p) {
+    switch (format) {
+        case CONVERT_S16: {
+            int16_t v;
+            memcpy(&v, p, sizeof(v));
+            return v;
+        }
+        case CONVERT_S24:
+            return (int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 24);
+        default: {
+            int32_t v;
+            memcpy(&v, p, sizeof(v));
+            return v;
+        }
+    }
+}
+
+// Any layout: gather one channel's samples a vector at a time
+static void deinterleave_channel(convert_format_t format, const uint8_t *src, size_t frame_bytes,
+                                 float *out, size_t count) {
+    if (format == CONVERT_F32) {
+        for (size_t i = 0; i < count; i++) {
+            memcpy(&out[i], src + i * frame_bytes, sizeof(float));
+        }
+        return;
+    }
+
+    float scale = format == CONVERT_S16 ? CONVERT_S16_SCALE : CONVERT_S32_SCALE;
+    size_t i = 0;
+    for (; i + CONVERT_LANES <= count; i += CONVERT_LANES) {
+        v8i raw;
+        for (size_t k = 0; k < CONVERT_LANES; k++) {
+            raw[k] = load_int(format, src + (i + k) * frame_bytes);
+        }
+        v8f f = __builtin_convertvector(raw, v8f) * scale;
+        memcpy(out + i, &f, sizeof(f));
+    }
+    for (; i < count; i++) {
+        out[i] = (float)load_int(format, src + i * frame_bytes) * scale;
+    }
+}
+
+void convert_deinterleave(convert_format_t format, const void *src, uint32_t stride, uint32_t channels,
+                          float *const *dest, size_t offset, size_t count) {
+    size_t size = convert_sample_size(format);
+    size_t done = 0;
+    if (stride == 2 && channels == 2) {
+        float *left = dest[0] + offset, *right = dest[1] + offset;
+        switch (format) {
+            case CONVERT_F32: done = stereo_f32(src, left, right, count); break;
+            case CONVERT_S16: done = stereo_s16(src, left, right, count); break;
+            case CONVERT_S32: done = stereo_s32(src, left, right, count); break;
+            default: break;
+        }
+    }
+    if (done == count) return;
+
+    const uint8_t *bytes = (const uint8_t *)src + done * stride * size;
+    for (uint32_t c = 0; c < channels && c < stride; c++) {
+        deinterleave_channel(format, bytes + c * size, stride * size, dest[c] + offset + done, count - done);
+    }
+}
@@ -1,7 +1,9 @@
 #define _XOPEN_SOURCE_EXTENDED
 #include "display.h"
+#include "pacer.h"
 #include <locale.h>
 #include <math.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <wchar.h>
@@ -14,6 +16,14 @@ static const char *BAR_CHARS_UTF8[] = {" ", "▁", "▂", "▃", "▄", "▅", "
 static const char *PEAK_CHARS[] = {"🭶", "🭷", "🭸", "🭹", "🭺", "🭻", "▁", "▁"};
 constexpr int PEAK_POSITIONS = 8;
 
+// Braille dot bits for (column, row) within a 2x4 cell
+static const uint8_t BRAILLE_BITS[4][2] = {{0x01, 0x08}, {0x02, 0x10}, {0x04, 0x20}, {0x40, 0x80}};
+static const char *PHASE_BAND_NAMES[] = {"31", "63", "125", "250", "500", "1k", "2k", "4k", "8k", "16k"};
+constexpr int PHASE_PANEL_WIDTH = 34;       // band coherence table right of the scope
+
+// Persistence density is log-compressed so rare hits stay visible
+constexpr double PERSISTENCE_CONTRAST = 200.0;
+
 // Color pairs for 8-color fallback
 enum {
     PAIR_STATUS = 9,
@@ -94,6 +104,217 @@ static rgb_t get_gradient_color(colormap_t map, double t) {
     }
 }
 
+// Colormap as packed RGBA pixels (byte order r, g, b, a) for pixel renderers
+static void fill_lut(colormap_t map, uint32_t lut[256]) {
+    for (int i = 0; i < 256; i++) {
+        rgb_t c = get_gradient_color(map, i / 255.0);
+        unsigned char px[4] = {c.r, c.g, c.b, 255};
+        memcpy(&lut[i], px, sizeof(px));
+    }
+}
+
+static uint32_t pack_rgba(unsigned char r, unsigned char g, unsigned char b) {
+    unsigned char px[4] = {r, g, b, 255};
+    uint32_t packed;
+    memcpy(&packed, px, sizeof(packed));
+    return packed;
+}
+
+static void map_columns(const display_ctx_t *ctx, const size_t *bins, const double *spectrum,
+                        float *out, int n) {
+    for (int col = 0; col < n; col++) {
+        double scaled = spectrum[bins[col]] * ctx->gain;
+        if (scaled > 1.0) scaled = 1.0;
+        out[col] = (float)scaled;
+    }
+}
+
+// Same as map_columns for a quantized history row
+static void map_history_columns(const display_ctx_t *ctx, const size_t *bins, const uint8_t *row,
+                                float *out, int n) {
+    float scale = (float)(ctx->gain / 255.0);
+    for (int col = 0; col < n; col++) {
+        float scaled = row[bins[col]] * scale;
+        out[col] = scaled > 1.0f ? 1.0f : scaled;
+    }
+}
+
+// Fractional-octave bands spread over n columns, a gap between groups
+// wide enough to spare one
+static void map_band_columns(const display_ctx_t *ctx, float *out, int n) {
+    int bands = ctx->num_bands;
+    bool gaps = bands > 0 && n / bands >= 3;
+    for (int col = 0; col < n; col++) {
+        int band = bands > 0 ? (int)((long)col * bands / n) : 0;
+        int next = bands > 0 ? (int)((long)(col + 1) * bands / n) : 0;
+        if (bands == 0 || (gaps && next != band)) {
+            out[col] = 0.0f;
+            continue;
+        }
+        double scaled = ctx->band_levels[band] * ctx->gain;
+        out[col] = scaled > 1.0 ? 1.0f : (float)scaled;
+    }
+}
+
+// Compressed persistence density per level for one of n columns
+static void map_persistence_column(const display_ctx_t *ctx, const size_t *bins, int col, int n,
+                                   float levels[PERSISTENCE_LEVELS]) {
+    size_t last = col + 1 < n ? bins[col + 1] : bins[col] + 1;
+    persistence_column(&ctx->persistence, bins[col], last, levels);
+    float norm = (float)(1.0 / log1p(PERSISTENCE_CONTRAST));
+    for (int l = 0; l < PERSISTENCE_LEVELS; l++) {
+        levels[l] = log1pf(levels[l] * (float)PERSISTENCE_CONTRAST) * norm;
+    }
+}
+
+// Densest level shown by row (0 = top) of an h-row column, after gain
+static float persistence_cell(const display_ctx_t *ctx, const float levels[PERSISTENCE_LEVELS],
+                              int row, int h) {
+    double scale = PERSISTENCE_LEVELS / (ctx->gain * h);
+    int lo = (int)((h - 1 - row) * scale);
+    int hi = (int)ceil((h - row) * scale);
+    if (hi > PERSISTENCE_LEVELS) hi = PERSISTENCE_LEVELS;
+    if (hi <= lo) hi = lo + 1;
+    float density = 0.0f;
+    for (int l = lo; l < hi && l < PERSISTENCE_LEVELS; l++) {
+        if (levels[l] > density) density = levels[l];
+    }
+    return density;
+}
+
+// Rasterize into an RGBA image handed to the terminal out of band.
+// The live waterfall only sends the newly arrived line; a full image is
+// rebuilt from history after reconfiguration or when the view changes.
+// Colour nrows history rows starting at age first, newest on top
+static void waterfall_pixels(display_ctx_t *ctx, const size_t *bins, const uint32_t *lut, uint32_t bg,
+                             size_t first, int nrows, uint32_t *pixels) {
+    kitty_ctx_t *k = &ctx->kitty;
+    for (int y = 0; y < nrows; y++) {
+        const uint8_t *row = history_row(&ctx->history, first + y);
+        uint32_t *out = pixels + (size_t)y * k->width;
+        if (!row) {
+            for (int x = 0; x < k->width; x++) out[x] = bg;
+            continue;
+        }
+        map_history_columns(ctx, bins, row, k->columns, k->width);
+        for (int x = 0; x < k->width; x++) {
+            out[x] = lut[(int)(k->columns[x] * 255.0f)];
+        }
+    }
+}
+
+static bool draw_kitty(display_ctx_t *ctx, const double *spectrum, const uint8_t *past,
+                       size_t spectrum_size, int stats_rows, int bar_height) {
+    kitty_ctx_t *k = &ctx->kitty;
+    kitty_image_t content = ctx->waterfall_mode ? KITTY_IMAGE_WATERFALL : KITTY_IMAGE_SPECTRUM;
+    int configured = kitty_configure(k, stats_rows, ctx->width, bar_height, content);
+    if (configured < 0) {
+        return false;
+    }
+    bool full = configured > 0 || ctx->redraw;
+
+    // Images sit below text, so erase overlay text that was toggled off
+    if (ctx->redraw) {
+        printf("\033[48;2;30;30;30m");
+        for (int y = 0; y < bar_height; y++) {
+            printf("\033[%d;1H\033[%dX", y + 1 + stats_rows, ctx->width);
+        }
+    }
+
+    uint32_t lut[256];
+    fill_lut(ctx->colormap, lut);
+    uint32_t bg = pack_rgba(30, 30, 30);
+    const size_t *bins = bin_map_get(&ctx->pixel_map, ctx->sample_rate, spectrum_size, k->width);
+    if (!bins) return false;
+
+    if (content == KITTY_IMAGE_WATERFALL) {
+        if (!full && (ctx->paused || ctx->history_new == 0)) {
+            return true;  // anchored view or no new row, nothing new to show
+        }
+        if (ctx->history_new >= (size_t)k->height) {
+            full = true;
+        }
+
+        // A full image, or the rows pushed since the last frame, oldest first
+        if (full) {
+            uint32_t *pixels = (uint32_t *)kitty_begin(k, k->height);
+            if (!pixels) return false;
+            waterfall_pixels(ctx, bins, lut, bg, ctx->scroll, k->height, pixels);
+            return kitty_commit_image(k) == 0;
+        }
+        for (size_t age = ctx->history_new; age-- > 0;) {
+            uint32_t *pixels = (uint32_t *)kitty_begin(k, 1);
+            if (!pixels) return false;
+            waterfall_pixels(ctx, bins, lut, bg, age, 1, pixels);
+            if (kitty_commit_waterfall_row(k) != 0) return false;
+        }
+        return true;
+    }
+
+    int h = k->height;
+    if (ctx->persistence_mode && ctx->persistence.counts) {
+        uint32_t *pixels = (uint32_t *)kitty_begin(k, h);
+        if (!pixels) return false;
+        float levels[PERSISTENCE_LEVELS];
+        for (int x = 0; x < k->width; x++) {
+            map_persistence_column(ctx, bins, x, k->width, levels);
+            for (int y = 0; y < h; y++) {
+                float density = persistence_cell(ctx, levels, y, h);
+                pixels[(size_t)y * k->width + x] = density > 0.0f ? lut[(int)(density * 255.0f)] : bg;
+            }
+        }
+        return kitty_commit_image(k) == 0;
+    }
+
+    if (ctx->octave_fraction > 0) {
+        map_band_columns(ctx, k->columns, k->width);
+    } else if (past) {
+        map_history_columns(ctx, bins, past, k->columns, k->width);
+    } else {
+        map_columns(ctx, bins, spectrum, k->columns, k->width);
+    }
+
+    uint32_t peak = pack_rgba(180, 0, 0);
+    for (int x = 0; x < k->width; x++) {
+        k->heights[x] = (int)(k->columns[x] * h);
+    }
+
+    uint32_t *pixels = (uint32_t *)kitty_begin(k, h);
+    if (!pixels) return false;
+    for (int y = 0; y < h; y++) {
+        int level = h - y;  // pixels from the bottom, inclusive
+        uint32_t fg = lut[(h - 1 - y) * 255 / (h > 1 ? h - 1 : 1)];
+        uint32_t *row = pixels + (size_t)y * k->width;
+        for (int x = 0; x < k->width; x++) {
+            row[x] = k->heights[x] >= level ? fg : bg;
+        }
+    }
+
+    // Peak markers: a short line across each cell column
+    int thickness = k->cell_h / 8 > 1 ? k->cell_h / 8 : 1;
+    for (int bar = 0; bar < ctx->num_bars && bar < k->cols; bar++) {
+        float value = ctx->peaks.value[bar];
+        if (value <= 0.01f) continue;
+        int top = h - 1 - (int)(value * (h - 1));
+        for (int y = top; y < top + thickness && y < h; y++) {
+            uint32_t *row = pixels + (size_t)y * k->width + (size_t)bar * k->cell_w;
+            for (int x = 0; x < k->cell_w; x++) {
+                row[x] = peak;
+            }
+        }
+    }
+    return kitty_commit_image(k) == 0;
+}
+
+// Meter readout, "-inf" below the measurable range
+static void format_level(char *buf, size_t size, double value) {
+    if (isfinite(value)) {
+        snprintf(buf, size, "%5.1f", value);
+    } else {
+        snprintf(buf, size, " -inf");
+    }
+}
+
 static bool detect_truecolor(void) {
     const char *colorterm = getenv("COLORTERM");
     if (colorterm && (strcmp(colorterm, "truecolor") == 0 ||
@@ -153,6 +374,7 @@ int display_init(display_ctx_t *ctx) {
     setlocale(LC_ALL, "");
 
     ctx->use_truecolor = detect_truecolor();
+    ctx->use_kitty = ctx->use_truecolor && kitty_detect() && kitty_init(&ctx->kitty) == 0;
 
     set_escdelay(25);  // Fast ESC response (default is 1000ms)
     ctx->win = initscr();
@@ -176,25 +398,46 @@ int display_init(display_ctx_t *ctx) {
 
     getmaxyx(ctx->win, ctx->height, ctx->width);
     ctx->num_bars = ctx->width;
-    ctx->bar_values = calloc(ctx->num_bars, sizeof(double));
-    ctx->peak_values = calloc(ctx->num_bars, sizeof(double));
-    ctx->peak_hold_frames = calloc(ctx->num_bars, sizeof(int));
-    ctx->waterfall = calloc((size_t)WATERFALL_HISTORY * ctx->num_bars, sizeof(double));
-    ctx->waterfall_pos = 0;
+    ctx->bar_capacity = ctx->width > DISPLAY_RESERVE_COLUMNS ? ctx->width : DISPLAY_RESERVE_COLUMNS;
+    ctx->bar_values = peaks_alloc_levels(ctx->bar_capacity);
+    ctx->last_update = pacer_now();
+    int peaks_ret = peaks_init(&ctx->peaks, ctx->bar_capacity, ctx->last_update);
+    peaks_reset(&ctx->peaks, ctx->num_bars);
+    ctx->paused = false;
+    ctx->scroll = 0;
     ctx->gain = 1.5;
     ctx->show_info = false;
     ctx->show_stats = false;
+    ctx->show_loudness = false;
+    ctx->reset_requested = false;
+    ctx->recording = false;
     ctx->waterfall_mode = false;
+    ctx->persistence_mode = false;
+    ctx->persistence_time = PERSISTENCE_TIME;
+    ctx->phase_mode = false;
+    ctx->octave_fraction = 0;
+    ctx->octave_weighting = OCTAVE_FAST;
+    ctx->num_bands = 0;
+    ctx->average = SPECTRUM_AVG_EXP;
+    ctx->show_tonal = false;
+    tonal_reset(&ctx->tonal);
     ctx->peak_hold_time = 0.5;  // 0.5 second default
+    ctx->peak_attack = 0.0;     // instant
+    ctx->peak_release = 96.0;   // 0.02 of full height per frame at 60 fps
     ctx->max_sample = 0;
     ctx->rms_left = 0;
     ctx->rms_right = 0;
-    ctx->stats_frame = 0;
     ctx->stereo = false;
     memset(ctx->peak_history, 0, sizeof(ctx->peak_history));
-    memset(ctx->rms_history_l, 0, sizeof(ctx->rms_history_l));
-    memset(ctx->rms_history_r, 0, sizeof(ctx->rms_history_r));
+    ctx->peak_index = 0;
+    ctx->block_peak = 0;
+    ctx->block_sum_l = 0;
+    ctx->block_sum_r = 0;
+    ctx->block_frames = 0;
     ctx->sample_rate = 48000;  // default, updated from audio
+    ctx->view = 0;
+    ctx->num_views = 1;
+    ctx->view_names[0] = "mix";
 
     // Set dark grey background for truecolor
     if (ctx->use_truecolor) {
@@ -202,148 +445,447 @@ int display_init(display_ctx_t *ctx) {
         fflush(stdout);
     }
 
-    return (ctx->bar_values && ctx->peak_values) ? 0 : -1;
+    return (ctx->bar_values && peaks_ret == 0) ? 0 : -1;
 }
 
 void display_shutdown(display_ctx_t *ctx) {
+    if (ctx->use_kitty) {
+        kitty_shutdown(&ctx->kitty);
+    }
     if (ctx->use_truecolor) {
         printf("\033[0m\033[2J\033[H");
         fflush(stdout);
     }
     free(ctx->bar_values);
-    free(ctx->peak_values);
-    free(ctx->peak_hold_frames);
-    free(ctx->waterfall);
+    peaks_shutdown(&ctx->peaks);
+    history_shutdown(&ctx->history);
+    persistence_shutdown(&ctx->persistence);
+    phase_shutdown(&ctx->phase);
+    bin_map_shutdown(&ctx->bar_map);
+    bin_map_shutdown(&ctx->pixel_map);
     endwin();
     memset(ctx, 0, sizeof(*ctx));
 }
 
+// Blank cells the terminal just exposed; everything else is overdrawn by
+// the next frame anyway
+static void clear_exposed(display_ctx_t *ctx, int old_w, int old_h) {
+    if (!ctx->use_truecolor) return;  // ncurses blanks new area itself
+    printf("\033[48;2;30;30;30m");
+    for (int y = 0; y < ctx->height; y++) {
+        if (y >= old_h) {
+            printf("\033[%d;1H\033[%dX", y + 1, ctx->width);
+        } else if (ctx->width > old_w) {
+            printf("\033[%d;%dH\033[%dX", y + 1, old_w + 1, ctx->width - old_w);
+        }
+    }
+}
+
 void display_resize(display_ctx_t *ctx) {
-    endwin();
-    refresh();
+    int old_w = ctx->width, old_h = ctx->height;
     getmaxyx(ctx->win, ctx->height, ctx->width);
+    ctx->resize_pending = false;
+    if (ctx->width == old_w && ctx->height == old_h) return;
 
-    free(ctx->bar_values);
-    free(ctx->peak_values);
-    free(ctx->peak_hold_frames);
-    free(ctx->waterfall);
-    ctx->num_bars = ctx->width;
-    ctx->bar_values = calloc(ctx->num_bars, sizeof(double));
-    ctx->peak_values = calloc(ctx->num_bars, sizeof(double));
-    ctx->peak_hold_frames = calloc(ctx->num_bars, sizeof(int));
-    ctx->waterfall = calloc((size_t)WATERFALL_HISTORY * ctx->num_bars, sizeof(double));
-    ctx->waterfall_pos = 0;
-    clear();
+    // Bar storage only grows past the reserve; history is kept per FFT
+    // bin and the peaks are resampled, so nothing on screen is lost
+    if (ctx->width > ctx->bar_capacity) {
+        int capacity = ctx->width * 2;
+        float *values = peaks_alloc_levels(capacity);
+        if (values && peaks_reserve(&ctx->peaks, capacity) == 0) {
+            free(ctx->bar_values);
+            ctx->bar_values = values;
+            ctx->bar_capacity = capacity;
+        } else {
+            free(values);
+        }
+    }
+    ctx->num_bars = ctx->width < ctx->bar_capacity ? ctx->width : ctx->bar_capacity;
+    peaks_remap(&ctx->peaks, ctx->num_bars);
+    ctx->idle_drawn = false;
+
+    // Overlays and the non-bar views leave text that moves with the
+    // geometry; those still get a full repaint
+    bool bars = !ctx->waterfall_mode && !ctx->persistence_mode && !ctx->phase_mode;
+    if (ctx->show_info || !bars || ctx->use_kitty) {
+        ctx->redraw = true;
+        ctx->needs_refresh = true;
+        if (ctx->use_truecolor) {
+            printf("\033[48;2;30;30;30m\033[2J");
+        } else {
+            clear();
+        }
+    } else {
+        // ncurses only needs its own refresh when it is doing the drawing
+        ctx->needs_refresh = !ctx->use_truecolor;
+        clear_exposed(ctx, old_w, old_h);
+    }
+}
+
+bool display_is_idle(const display_ctx_t *ctx) {
+    return ctx->silent && ctx->settled;
 }
 
 void display_update_stats(display_ctx_t *ctx, const float *samples_l, const float *samples_r, size_t count) {
-    // Calculate this frame's peak and RMS for both channels
-    double frame_peak = 0;
+    if (count == 0) return;
+
     double sum_sq_l = 0;
     double sum_sq_r = 0;
-
+    double sum_lr = 0;
     for (size_t i = 0; i < count; i++) {
         double abs_l = fabs(samples_l[i]);
         double abs_r = fabs(samples_r[i]);
         double abs_max = abs_l > abs_r ? abs_l : abs_r;
-        if (abs_max > frame_peak) frame_peak = abs_max;
+        if (abs_max > ctx->block_peak) ctx->block_peak = abs_max;
         sum_sq_l += samples_l[i] * samples_l[i];
         sum_sq_r += samples_r[i] * samples_r[i];
+        sum_lr += samples_l[i] * samples_r[i];
     }
-    double frame_rms_l = sqrt(sum_sq_l / count);
-    double frame_rms_r = sqrt(sum_sq_r / count);
+    phase_update_correlation(&ctx->phase, sum_lr, sum_sq_l, sum_sq_r, (double)count / ctx->sample_rate);
+    ctx->silent = sqrt(sum_sq_l / count) < DISPLAY_SILENCE_RMS && sqrt(sum_sq_r / count) < DISPLAY_SILENCE_RMS;
 
-    // Store in rolling buffers
-    int peak_idx = ctx->stats_frame % 180;  // 3 sec window
-    int rms_idx = ctx->stats_frame % 15;    // 250ms window
-    ctx->peak_history[peak_idx] = frame_peak;
-    ctx->rms_history_l[rms_idx] = frame_rms_l * frame_rms_l;
-    ctx->rms_history_r[rms_idx] = frame_rms_r * frame_rms_r;
+    ctx->block_sum_l += sum_sq_l;
+    ctx->block_sum_r += sum_sq_r;
+    ctx->block_frames += count;
 
-    // Update displayed values at 4Hz (every 15 frames at 60fps)
-    if (ctx->stats_frame % 15 == 0) {
-        // Peak: max over 3 second window
-        double peak = 0;
-        for (int i = 0; i < 180; i++) {
-            if (ctx->peak_history[i] > peak) peak = ctx->peak_history[i];
+    // Publish once per DISPLAY_STATS_SECONDS of audio: RMS over that block,
+    // peak over the last DISPLAY_PEAK_BLOCKS of them
+    size_t block_len = (size_t)(DISPLAY_STATS_SECONDS * ctx->sample_rate);
+    if (ctx->block_frames < block_len) return;
+
+    ctx->peak_history[ctx->peak_index] = ctx->block_peak;
+    ctx->peak_index = (ctx->peak_index + 1) % DISPLAY_PEAK_BLOCKS;
+    double peak = 0;
+    for (int i = 0; i < DISPLAY_PEAK_BLOCKS; i++) {
+        if (ctx->peak_history[i] > peak) peak = ctx->peak_history[i];
+    }
+    ctx->max_sample = peak;
+    ctx->rms_left = sqrt(ctx->block_sum_l / ctx->block_frames);
+    ctx->rms_right = sqrt(ctx->block_sum_r / ctx->block_frames);
+
+    ctx->block_peak = 0;
+    ctx->block_sum_l = 0;
+    ctx->block_sum_r = 0;
+    ctx->block_frames = 0;
+}
+
+void display_add_persistence(display_ctx_t *ctx, const double *spectrum, size_t spectrum_size) {
+    if (ctx->persistence.bins != spectrum_size) {
+        persistence_shutdown(&ctx->persistence);
+        if (persistence_init(&ctx->persistence, spectrum_size) != 0) return;
+    }
+    double frame_rate = (double)ctx->sample_rate / PERSISTENCE_HOP;
+    if (ctx->persistence.frame_rate != frame_rate || ctx->persistence.time != ctx->persistence_time) {
+        persistence_set_decay(&ctx->persistence, frame_rate, ctx->persistence_time);
+        ctx->persistence_time = ctx->persistence.time;  // clamped to what fits
+    }
+    persistence_add(&ctx->persistence, spectrum);
+}
+
+// Scope size in cells: square in braille dots, leaving room for the band
+// table on the right and the correlation meter on the last row
+static void phase_layout(const display_ctx_t *ctx, int *rows, int *cols) {
+    int stats_rows = (ctx->show_stats ? 1 : 0) + (ctx->show_loudness ? 1 : 0);
+    *rows = ctx->height - stats_rows - 1;
+    *cols = *rows * 2;
+    if (*cols > ctx->width - PHASE_PANEL_WIDTH) *cols = ctx->width - PHASE_PANEL_WIDTH;
+    if (*cols < 8) *cols = ctx->width;
+    if (*rows < 1) *rows = 0;
+}
+
+void display_update_phase(display_ctx_t *ctx, const float *samples_l, const float *samples_r, size_t count,
+                          const fftw_complex *bins_l, const fftw_complex *bins_r, size_t bins) {
+    int rows, cols;
+    phase_layout(ctx, &rows, &cols);
+    double seconds = (double)count / ctx->sample_rate;
+    phase_update_bands(&ctx->phase, bins_l, bins_r, bins, ctx->sample_rate, seconds);
+    phase_update_scope(&ctx->phase, samples_l, samples_r, count, cols * 2, rows * 4, ctx->gain, seconds);
+}
+
+void display_update_tonal(display_ctx_t *ctx, const double *spectrum, size_t spectrum_size) {
+    tonal_update(&ctx->tonal, spectrum, spectrum_size, ctx->sample_rate);
+}
+
+void display_set_bands(display_ctx_t *ctx, const double *levels_db, const double *centres, int count) {
+    if (count > OCTAVE_MAX_BANDS) count = OCTAVE_MAX_BANDS;
+    for (int i = 0; i < count; i++) {
+        double level = (levels_db[i] + DISPLAY_DB_RANGE) / DISPLAY_DB_RANGE;
+        ctx->band_levels[i] = level < 0.0 ? 0.0f : level > 1.0 ? 1.0f : (float)level;
+        ctx->band_centres[i] = centres[i];
+    }
+    ctx->num_bands = count;
+}
+
+// Nominal band centres along the bottom row, skipping those that would overlap
+static void draw_band_labels(display_ctx_t *ctx, int stats_rows, int bar_height) {
+    int n = ctx->num_bars < ctx->width ? ctx->num_bars : ctx->width;
+    int free_col = 0;
+    for (int b = 0; b < ctx->num_bands; b++) {
+        int first = (int)(((long)b * n + ctx->num_bands - 1) / ctx->num_bands);
+        int next = (int)(((long)(b + 1) * n + ctx->num_bands - 1) / ctx->num_bands);
+        char name[16];
+        octave_band_label(ctx->band_centres[b], ctx->octave_fraction, name, sizeof(name));
+        int len = (int)strlen(name);
+        int x = (first + next) / 2 - len / 2;
+        if (x < free_col) x = free_col;
+        if (x + len > n || x >= next) continue;
+        if (ctx->use_truecolor) {
+            printf("\033[%d;%dH\033[38;2;200;200;200;48;2;30;30;30m%s\033[0m",
+                   stats_rows + bar_height, x + 1, name);
+        } else {
+            mvprintw(stats_rows + bar_height - 1, x, "%s", name);
+        }
+        free_col = x + len + 1;
+    }
+}
+
+// Top-N tonal peaks, one line each, under the label in the top-left corner
+static void draw_tonal(display_ctx_t *ctx, int stats_rows) {
+    for (int i = 0; i < TONAL_TOP; i++) {
+        char line[64] = "";
+        if (i < ctx->tonal.num_top) {
+            const tonal_peak_t *peak = &ctx->tonal.top[i];
+            char note[16];
+            tonal_note_name(peak->freq, note, sizeof(note));
+            snprintf(line, sizeof(line), " %9.1f Hz %6.1f dBFS  %-9s", peak->freq, peak->dbfs, note);
+        } else {
+            snprintf(line, sizeof(line), "%38s", "");
+        }
+        if (ctx->use_truecolor) {
+            printf("\033[%d;2H\033[38;2;255;255;255;48;2;20;20;20m%s\033[0m", i + 3 + stats_rows, line);
+        } else {
+            attron(A_BOLD);
+            mvprintw(i + 2 + stats_rows, 1, "%s", line);
+            attroff(A_BOLD);
+        }
+    }
+}
+
+static void draw_phase(display_ctx_t *ctx, int stats_rows) {
+    const phase_ctx_t *p = &ctx->phase;
+    int rows, cols;
+    phase_layout(ctx, &rows, &cols);
+
+    // Vectorscope: one braille cell per 2x4 dots, colored by the brightest dot
+    for (int cy = 0; cy < rows; cy++) {
+        for (int cx = 0; cx < cols; cx++) {
+            uint8_t bits = 0;
+            float level = 0.0f;
+            for (int dy = 0; dy < 4 && p->scope; dy++) {
+                for (int dx = 0; dx < 2; dx++) {
+                    int x = cx * 2 + dx, y = cy * 4 + dy;
+                    if (x >= p->dots_w || y >= p->dots_h) continue;
+                    float v = p->scope[(size_t)y * p->dots_w + x];
+                    if (v > 0.05f) bits |= BRAILLE_BITS[dy][dx];
+                    if (v > level) level = v;
+                }
+            }
+            wchar_t glyph = bits ? (wchar_t)(0x2800 + bits) : L' ';
+            if (ctx->use_truecolor) {
+                rgb_t c = get_gradient_color(ctx->colormap, level);
+                char utf8[4] = {(char)(0xe2), (char)(0xa0 | ((bits >> 6) & 0x03)), (char)(0x80 | (bits & 0x3f)), 0};
+                printf("\033[%d;%dH\033[38;2;%d;%d;%d;48;2;30;30;30m%s", cy + 1 + stats_rows, cx + 1,
+                       c.r, c.g, c.b, bits ? utf8 : " ");
+            } else {
+                wchar_t wstr[2] = {glyph, L'\0'};
+                int pair = 1 + (int)(level * 7);
+                if (pair > 8) pair = 8;
+                move(cy + stats_rows, cx);
+                if (ctx->use_color) attron(COLOR_PAIR(pair));
+                addwstr(wstr);
+                if (ctx->use_color) attroff(COLOR_PAIR(pair));
+            }
         }
-        ctx->max_sample = peak;
+    }
 
-        // RMS: average over 250ms window for each channel
-        double rms_sum_l = 0;
-        double rms_sum_r = 0;
-        for (int i = 0; i < 15; i++) {
-            rms_sum_l += ctx->rms_history_l[i];
-            rms_sum_r += ctx->rms_history_r[i];
+    // Per-band coherence and phase of R relative to L
+    if (cols < ctx->width) {
+        int x0 = cols + 2;
+        for (int b = -1; b < PHASE_BANDS && b + 1 < rows; b++) {
+            char line[64];
+            if (b < 0) {
+                snprintf(line, sizeof(line), " band  coh  phase  coherence  ");
+            } else {
+                char bar[11];
+                int filled = (int)(p->coherence[b] * 10.0 + 0.5);
+                for (int i = 0; i < 10; i++) bar[i] = i < filled ? '#' : '.';
+                bar[10] = '\0';
+                snprintf(line, sizeof(line), " %4s  %.2f  %+4.0f  %s  ", PHASE_BAND_NAMES[b],
+                         p->coherence[b], p->phase[b], bar);
+            }
+            if (ctx->use_truecolor) {
+                printf("\033[%d;%dH\033[38;2;200;200;200;48;2;30;30;30m%s", b + 2 + stats_rows, x0, line);
+            } else {
+                mvprintw(b + 1 + stats_rows, x0 - 1, "%s", line);
+            }
         }
-        ctx->rms_left = sqrt(rms_sum_l / 15);
-        ctx->rms_right = sqrt(rms_sum_r / 15);
     }
 
-    ctx->stats_frame++;
+    // Correlation meter: -1 (out of phase) .. +1 (mono)
+    int meter_row = stats_rows + rows;
+    int meter_w = ctx->width - 20;
+    if (meter_w < 3) return;
+    int marker = (int)((p->correlation + 1.0) * 0.5 * (meter_w - 1) + 0.5);
+    if (ctx->use_truecolor) {
+        printf("\033[%d;1H\033[38;2;200;200;200;48;2;30;30;30m corr %+.2f -1 ", meter_row + 1, p->correlation);
+        for (int i = 0; i < meter_w; i++) {
+            if (i == marker) {
+                rgb_t c = p->correlation < 0.0 ? (rgb_t){220, 40, 40} : (rgb_t){40, 200, 60};
+                printf("\033[38;2;%d;%d;%dm█\033[38;2;200;200;200m", c.r, c.g, c.b);
+            } else {
+                putchar(i == meter_w / 2 ? '|' : '-');
+            }
+        }
+        printf(" +1");
+    } else {
+        mvprintw(meter_row, 0, " corr %+.2f -1 ", p->correlation);
+        for (int i = 0; i < meter_w; i++) {
+            addch(i == marker ? '#' : i == meter_w / 2 ? '|' : '-');
+        }
+        addstr(" +1");
+    }
 }
 
-void display_update(display_ctx_t *ctx, const double *spectrum, size_t spectrum_size) {
-    if (!ctx->bar_values || !ctx->peak_values) return;
+void display_update(display_ctx_t *ctx, const double *spectrum, size_t spectrum_size, uint64_t frame) {
+    if (ctx->resize_pending) {
+        display_resize(ctx);
+    }
+    if (!ctx->bar_values || !ctx->peaks.value) return;
 
-    int stats_rows = ctx->show_stats ? 1 : 0;
+    int stats_rows = (ctx->show_stats ? 1 : 0) + (ctx->show_loudness ? 1 : 0);
     int bar_height = ctx->height - stats_rows;
 
-    // Map spectrum bins to display bars using octave-based log scale
-    // Each octave (frequency doubling) takes equal visual space
-    constexpr double MIN_FREQ = 20.0;    // 20 Hz low end
-    double max_freq = ctx->sample_rate > 0 ? ctx->sample_rate / 2.0 : 24000.0;
-    double freq_ratio = max_freq / MIN_FREQ;
-    double bin_width = ctx->sample_rate > 0 ? (double)ctx->sample_rate / (spectrum_size * 2) : 11.7;
+    double now = pacer_now();
 
-    for (int bar = 0; bar < ctx->num_bars; bar++) {
-        double t = (double)bar / (ctx->num_bars - 1);  // 0 to 1
-        double freq = MIN_FREQ * pow(freq_ratio, t);   // exponential: octave spacing
-        size_t bin = (size_t)(freq / bin_width);
-        if (bin >= spectrum_size) bin = spectrum_size - 1;
-        if (bin < 1) bin = 1;  // skip DC
+    // One history row per HISTORY_ROW_SECONDS of captured audio, so the
+    // scrollback time axis holds at any redraw rate; rows due since the last
+    // frame all show the current spectrum. While paused keep the view
+    // anchored on the same row.
+    if (ctx->history.bins != spectrum_size) {
+        history_shutdown(&ctx->history);
+        size_t rows = (size_t)(HISTORY_MINUTES * 60.0 / HISTORY_ROW_SECONDS);
+        if (history_init(&ctx->history, spectrum_size, rows) != 0) return;
+        ctx->scroll = 0;
+        ctx->history_due = frame;
+    }
+    uint64_t row_frames = (uint64_t)(HISTORY_ROW_SECONDS * ctx->sample_rate);
+    if (row_frames < 1) row_frames = 1;
+    if (frame > ctx->history_due && frame - ctx->history_due > row_frames * ctx->history.capacity) {
+        ctx->history_due = frame - row_frames * (ctx->history.capacity - 1);  // older rows would be overwritten
+    }
+    ctx->history_new = 0;
+    while (ctx->history_due <= frame) {
+        history_push(&ctx->history, spectrum, now - (double)(frame - ctx->history_due) / ctx->sample_rate);
+        ctx->history_due += row_frames;
+        ctx->history_new++;
+    }
+    if (ctx->paused) {
+        ctx->scroll += ctx->history_new;
+        if (ctx->scroll >= ctx->history.count) {
+            ctx->scroll = ctx->history.count > 0 ? ctx->history.count - 1 : 0;
+        }
+    }
+    const uint8_t *past = ctx->paused ? history_row(&ctx->history, ctx->scroll) : NULL;
 
-        double scaled = spectrum[bin] * ctx->gain;
-        if (scaled > 1.0) scaled = 1.0;
-        ctx->bar_values[bar] = scaled;
-
-        // Update peak with hold time
-        if (scaled >= ctx->peak_values[bar]) {
-            ctx->peak_values[bar] = scaled;
-            ctx->peak_hold_frames[bar] = (int)(ctx->peak_hold_time * 60);  // hold for N frames
-        } else if (ctx->peak_hold_frames[bar] > 0) {
-            ctx->peak_hold_frames[bar]--;  // holding at peak
-        } else {
-            ctx->peak_values[bar] -= 0.02;  // falling
-            if (ctx->peak_values[bar] < 0) ctx->peak_values[bar] = 0;
+    const size_t *bins = bin_map_get(&ctx->bar_map, ctx->sample_rate, spectrum_size, ctx->num_bars);
+    if (!bins) return;
+    if (ctx->octave_fraction > 0) {
+        map_band_columns(ctx, ctx->bar_values, ctx->num_bars);
+    } else if (past) {
+        map_history_columns(ctx, bins, past, ctx->bar_values, ctx->num_bars);
+    } else {
+        map_columns(ctx, bins, spectrum, ctx->bar_values, ctx->num_bars);
+    }
+
+    // Peak hold and decay follow wall-clock time, independent of frame rate;
+    // a paused view freezes them with the bars
+    if (!ctx->paused) {
+        peaks_update(&ctx->peaks, ctx->bar_values, now, now - ctx->last_update,
+                     ctx->peak_hold_time,
+                     ctx->peak_attack / DISPLAY_DB_RANGE,
+                     ctx->peak_release / DISPLAY_DB_RANGE);
+    }
+    ctx->last_update = now;
+
+    // Once everything has decayed the bar view is static; draw it once
+    bool settled = true;
+    for (int bar = 0; bar < ctx->num_bars; bar++) {
+        if (ctx->bar_values[bar] > 0.01 || ctx->peaks.value[bar] > 0.01) {
+            settled = false;
+            break;
         }
     }
+    ctx->settled = settled;
+    bool static_frame = ctx->paused ||
+                        (settled && !ctx->waterfall_mode && !ctx->persistence_mode && !ctx->phase_mode);
+    if (static_frame && ctx->idle_drawn) {
+        return;
+    }
+    ctx->idle_drawn = static_frame;
 
-    // Store in waterfall history
-    if (ctx->waterfall) {
-        for (int bar = 0; bar < ctx->num_bars; bar++) {
-            ctx->waterfall[ctx->waterfall_pos * ctx->num_bars + bar] = ctx->bar_values[bar];
+    bool drawn = false;
+    if (ctx->use_kitty && ctx->phase_mode) {
+        kitty_clear(&ctx->kitty);  // the scope is text; drop any image below it
+    } else if (ctx->use_kitty) {
+        drawn = draw_kitty(ctx, spectrum, past, spectrum_size, stats_rows, bar_height);
+        if (!drawn) {
+            // Terminal can't do pixel output after all; use cells from now on
+            kitty_shutdown(&ctx->kitty);
+            ctx->use_kitty = false;
         }
-        ctx->waterfall_pos = (ctx->waterfall_pos + 1) % WATERFALL_HISTORY;
     }
 
-    if (ctx->waterfall_mode && ctx->use_truecolor) {
+    if (ctx->phase_mode) {
+        draw_phase(ctx, stats_rows);
+    } else if (!drawn && ctx->persistence_mode && ctx->persistence.counts) {
+        // Persistence mode: hit density per cell, colored by the colormap
+        float levels[PERSISTENCE_LEVELS];
+        for (int x = 0; x < ctx->num_bars && x < ctx->width; x++) {
+            map_persistence_column(ctx, bins, x, ctx->num_bars, levels);
+            for (int y = 0; y < bar_height; y++) {
+                float density = persistence_cell(ctx, levels, y, bar_height);
+                if (ctx->use_truecolor) {
+                    if (density > 0.0f) {
+                        rgb_t c = get_gradient_color(ctx->colormap, density);
+                        printf("\033[%d;%dH\033[38;2;%d;%d;%d;48;2;30;30;30m█", y + 1 + stats_rows, x + 1, c.r, c.g, c.b);
+                    } else {
+                        printf("\033[%d;%dH\033[48;2;30;30;30m ", y + 1 + stats_rows, x + 1);
+                    }
+                } else {
+                    move(y + stats_rows, x);
+                    if (density > 0.0f && ctx->use_color) {
+                        int color_pair = 1 + (int)(density * 7);
+                        if (color_pair > 8) color_pair = 8;
+                        attron(COLOR_PAIR(color_pair));
+                        addwstr(L"█");
+                        attroff(COLOR_PAIR(color_pair));
+                    } else {
+                        addch(density > 0.5f ? '#' : density > 0.0f ? '.' : ' ');
+                    }
+                }
+            }
+        }
+    } else if (!drawn && ctx->waterfall_mode && ctx->use_truecolor) {
         // Waterfall mode: draw history scrolling down
-        for (int y = 0; y < bar_height && y < WATERFALL_HISTORY; y++) {
-            int hist_idx = (ctx->waterfall_pos - 1 - y + WATERFALL_HISTORY) % WATERFALL_HISTORY;
-            if (hist_idx < 0) hist_idx += WATERFALL_HISTORY;
+        for (int y = 0; y < bar_height; y++) {
+            const uint8_t *row = history_row(&ctx->history, ctx->scroll + y);
+            if (!row) {
+                printf("\033[%d;1H\033[48;2;30;30;30m\033[%dX", y + 1 + stats_rows, ctx->width);
+                continue;
+            }
             for (int x = 0; x < ctx->num_bars && x < ctx->width; x++) {
-                double val = ctx->waterfall[hist_idx * ctx->num_bars + x];
+                double val = row[bins[x]] * ctx->gain / 255.0;
+                if (val > 1.0) val = 1.0;
                 rgb_t c = get_gradient_color(ctx->colormap, val);
                 printf("\033[%d;%dH\033[38;2;%d;%d;%d;48;2;30;30;30m█", y + 1 + stats_rows, x + 1, c.r, c.g, c.b);
             }
         }
-    } else {
+    } else if (!drawn) {
         // Normal spectrum mode
         for (int x = 0; x < ctx->num_bars && x < ctx->width; x++) {
             double value = ctx->bar_values[x];
             double full_height = value * bar_height * BAR_LEVELS;
-            double peak_pos = ctx->peak_values[x] * bar_height;
+            double peak_pos = ctx->peaks.value[x] * bar_height;
             int peak_row = bar_height - 1 - (int)peak_pos;
             double peak_frac = peak_pos - (int)peak_pos;
             int peak_char_idx = (int)((1.0 - peak_frac) * PEAK_POSITIONS);
@@ -361,7 +903,7 @@ void display_update(display_ctx_t *ctx, const double *spectrum, size_t spectrum_
                 }
 
                 double height_ratio = (double)y / bar_height;
-                bool is_peak = (row == peak_row && ctx->peak_values[x] > 0.01);
+                bool is_peak = (row == peak_row && ctx->peaks.value[x] > 0.01);
 
                 if (is_peak && char_idx == 0) {
                     if (ctx->use_truecolor) {
@@ -406,14 +948,70 @@ void display_update(display_ctx_t *ctx, const double *spectrum, size_t spectrum_
         }
     }
 
+    if (ctx->octave_fraction > 0 && !ctx->phase_mode) {
+        draw_band_labels(ctx, stats_rows, bar_height);
+    }
+    if (ctx->show_tonal && !ctx->phase_mode) {
+        draw_tonal(ctx, stats_rows);
+    }
+
+    // Label the selected channel when not showing the mix, and how far
+    // back a paused view is
+    char label[64] = "";
+    int len = 0;
+    if (ctx->view > 0 && ctx->view < ctx->num_views) {
+        len += snprintf(label + len, sizeof(label) - len, " %s ", ctx->view_names[ctx->view]);
+    }
+    if (ctx->octave_fraction > 0) {
+        static const char *weightings[OCTAVE_WEIGHTINGS] = {"fast", "slow", "Leq"};
+        len += snprintf(label + len, sizeof(label) - len, " 1/%d oct %s ", ctx->octave_fraction,
+                        weightings[ctx->octave_weighting]);
+    }
+    if (ctx->average == SPECTRUM_AVG_MAX || ctx->average == SPECTRUM_AVG_MIN) {
+        len += snprintf(label + len, sizeof(label) - len, " %s ", ctx->average == SPECTRUM_AVG_MAX ? "MAX" : "MIN");
+    }
+    if (ctx->recording) {
+        len += snprintf(label + len, sizeof(label) - len, " REC ");
+    }
+    if (ctx->paused) {
+        snprintf(label + len, sizeof(label) - len, " PAUSED -%.1fs ",
+                 now - history_time(&ctx->history, ctx->scroll));
+    }
+    if (label[0]) {
+        if (ctx->use_truecolor) {
+            printf("\033[%d;2H\033[38;2;200;200;200;48;2;30;30;30m%s\033[0m",
+                   1 + stats_rows, label);
+        } else {
+            attron(A_BOLD);
+            mvprintw(stats_rows, 1, "%s", label);
+            attroff(A_BOLD);
+        }
+    }
+
     if (ctx->use_truecolor) {
         fflush(stdout);
     }
-    refresh();
+    ctx->redraw = false;
+
+    // Truecolor output bypasses ncurses; only refresh when its state changed
+    if (!ctx->use_truecolor || ctx->needs_refresh) {
+        refresh();
+        ctx->needs_refresh = false;
+    }
 }
 
 bool display_handle_input(display_ctx_t *ctx, int *smoothing_percent) {
     int ch = getch();
+    if (ch != ERR && ch != KEY_RESIZE) {
+        ctx->idle_drawn = false;
+        ctx->redraw = true;
+    }
+
+    // History rows per scroll step and per page
+    int step = ctx->use_kitty ? ctx->kitty.cell_h : 1;
+    int page = ctx->use_kitty ? ctx->kitty.height : ctx->height;
+    if (step < 1) step = 1;
+    if (page < 1) page = 1;
 
     switch (ch) {
         case 'q':
@@ -431,9 +1029,83 @@ bool display_handle_input(display_ctx_t *ctx, int *smoothing_percent) {
             ctx->show_stats = !ctx->show_stats;
             break;
 
+        case 'l':
+        case 'L':
+            ctx->show_loudness = !ctx->show_loudness;
+            break;
+
+        case 'x':
+        case 'X':
+            ctx->reset_requested = true;
+            if (ctx->persistence.counts) persistence_clear(&ctx->persistence);
+            break;
+
+        case 't':
+        case 'T':
+            ctx->show_tonal = !ctx->show_tonal;
+            tonal_reset(&ctx->tonal);
+            break;
+
+        case 'm':
+        case 'M':
+            ctx->average = (ctx->average + 1) % SPECTRUM_AVG_COUNT;
+            break;
+
+        case 'g':
+        case 'G':
+            ctx->phase_mode = !ctx->phase_mode;
+            ctx->waterfall_mode = false;
+            ctx->persistence_mode = false;
+            ctx->octave_fraction = 0;
+            phase_reset(&ctx->phase);
+            if (ctx->use_truecolor) {
+                printf("\033[48;2;30;30;30m\033[2J");
+            } else {
+                clear();
+            }
+            break;
+
+        case 'p':
+        case 'P':
+            ctx->persistence_mode = !ctx->persistence_mode;
+            ctx->waterfall_mode = false;
+            ctx->phase_mode = false;
+            ctx->octave_fraction = 0;
+            if (ctx->persistence.counts) persistence_clear(&ctx->persistence);
+            break;
+
+        case '[':
+            ctx->persistence_time /= 1.5;
+            if (ctx->persistence_time < 0.1) ctx->persistence_time = 0.1;
+            break;
+
+        case ']':
+            ctx->persistence_time *= 1.5;
+            if (ctx->persistence_time > 30.0) ctx->persistence_time = 30.0;
+            break;
+
         case 'w':
         case 'W':
             ctx->waterfall_mode = !ctx->waterfall_mode;
+            ctx->persistence_mode = false;
+            ctx->phase_mode = false;
+            ctx->octave_fraction = 0;
+            break;
+
+        case 'o':
+        case 'O':
+            // off -> 1/1 -> 1/3 -> 1/6 octave bars
+            ctx->octave_fraction = ctx->octave_fraction == 0 ? 1 : ctx->octave_fraction == 1 ? 3 :
+                                   ctx->octave_fraction == 3 ? 6 : 0;
+            ctx->num_bands = 0;
+            ctx->waterfall_mode = false;
+            ctx->persistence_mode = false;
+            ctx->phase_mode = false;
+            break;
+
+        case 'k':
+        case 'K':
+            ctx->octave_weighting = (ctx->octave_weighting + 1) % OCTAVE_WEIGHTINGS;
             break;
 
         case 'r':
@@ -472,6 +1144,69 @@ bool display_handle_input(display_ctx_t *ctx, int *smoothing_percent) {
             if (ctx->peak_hold_time < 0) ctx->peak_hold_time = 0;
             break;
 
+        case 'y':
+        case 'Y':
+            if (ctx->peak_attack > 0) ctx->peak_attack += 50.0;
+            if (ctx->peak_attack > 1000.0) ctx->peak_attack = 0;  // instant
+            break;
+
+        case 'h':
+        case 'H':
+            if (ctx->peak_attack == 0) ctx->peak_attack = 1000.0;
+            ctx->peak_attack -= 50.0;
+            if (ctx->peak_attack < 50.0) ctx->peak_attack = 50.0;
+            break;
+
+        case 'u':
+        case 'U':
+            ctx->peak_release += 12.0;
+            if (ctx->peak_release > 480.0) ctx->peak_release = 480.0;
+            break;
+
+        case 'j':
+        case 'J':
+            ctx->peak_release -= 12.0;
+            if (ctx->peak_release < 12.0) ctx->peak_release = 12.0;
+            break;
+
+        case ' ':
+            ctx->paused = !ctx->paused;
+            ctx->scroll = 0;
+            break;
+
+        case KEY_UP:
+        case KEY_PPAGE:
+            ctx->paused = true;
+            ctx->scroll += ch == KEY_UP ? step : page;
+            if (ctx->scroll >= ctx->history.count) {
+                ctx->scroll = ctx->history.count > 0 ? ctx->history.count - 1 : 0;
+            }
+            break;
+
+        case KEY_DOWN:
+        case KEY_NPAGE: {
+            size_t delta = ch == KEY_DOWN ? step : page;
+            ctx->scroll = ctx->scroll > delta ? ctx->scroll - delta : 0;
+            break;
+        }
+
+        case KEY_HOME:
+            ctx->paused = true;
+            ctx->scroll = ctx->history.count > 0 ? ctx->history.count - 1 : 0;
+            break;
+
+        case KEY_END:
+            ctx->paused = false;
+            ctx->scroll = 0;
+            break;
+
+        case 'v':
+        case 'V':
+            ctx->view = (ctx->view + 1) % ctx->num_views;
+            peaks_reset(&ctx->peaks, ctx->num_bars);
+            if (ctx->persistence.counts) persistence_clear(&ctx->persistence);
+            break;
+
         case 'c':
         case 'C':
             ctx->colormap = (ctx->colormap + 1) % NUM_COLORMAPS;
@@ -481,7 +1216,8 @@ bool display_handle_input(display_ctx_t *ctx, int *smoothing_percent) {
             break;
 
         case KEY_RESIZE:
-            display_resize(ctx);
+            // Window managers send bursts; re-layout once per frame
+            ctx->resize_pending = true;
             break;
     }
 
@@ -499,12 +1235,12 @@ bool display_handle_input(display_ctx_t *ctx, int *smoothing_percent) {
             printf(" s16 Peak: %5d %.4f %5.1fdBFS | RMS: %.4f %5.1fdBFS ",
                    s16_peak, ctx->max_sample, db_peak, rms_avg, db_rms);
             if (ctx->stereo) {
-                printf("L/R: %+4.1fdB ", balance_db);
+                printf("L/R: %+4.1fdB Corr: %+.2f ", balance_db, ctx->phase.correlation);
             } else {
                 printf("(mono) ");
             }
             // Pad to width
-            int len = ctx->stereo ? 78 : 72;
+            int len = ctx->stereo ? 90 : 72;
             for (int i = len; i < ctx->width; i++) putchar(' ');
             printf("\033[0m");
             fflush(stdout);
@@ -516,10 +1252,36 @@ bool display_handle_input(display_ctx_t *ctx, int *smoothing_percent) {
         }
     }
 
+    // Draw loudness bar (below the stats bar)
+    if (ctx->show_loudness) {
+        const loudness_reading_t *m = &ctx->loudness;
+        char mom[16], st[16], integ[16], tp[16], tp_max[16];
+        format_level(mom, sizeof(mom), m->momentary);
+        format_level(st, sizeof(st), m->short_term);
+        format_level(integ, sizeof(integ), m->integrated);
+        format_level(tp, sizeof(tp), m->true_peak);
+        format_level(tp_max, sizeof(tp_max), m->true_peak_max);
+        int row = ctx->show_stats ? 1 : 0;
+
+        if (ctx->use_truecolor) {
+            printf("\033[%d;1H\033[38;2;255;255;255;48;2;30;30;30m", row + 1);
+            int len = printf(" M: %s  S: %s  I: %s LUFS | LRA: %4.1f LU | TP: %s (max %s) dBTP ",
+                             mom, st, integ, m->range, tp, tp_max);
+            for (int i = len; i < ctx->width; i++) putchar(' ');
+            printf("\033[0m");
+            fflush(stdout);
+        } else {
+            attron(A_BOLD);
+            mvprintw(row, 1, "M: %s  S: %s  I: %s LUFS  LRA: %4.1f LU  TP: %s (max %s) dBTP",
+                     mom, st, integ, m->range, tp, tp_max);
+            attroff(A_BOLD);
+        }
+    }
+
     // Draw info window (top right corner)
     if (ctx->show_info) {
         int info_w = 28;
-        int info_h = 12;
+        int info_h = 26;
         int info_x = ctx->width - info_w - 1;
         int info_y = 0;
 
@@ -538,14 +1300,35 @@ bool display_handle_input(display_ctx_t *ctx, int *smoothing_percent) {
                 }
             }
             // Content
-            printf("\033[%d;%dH  w      waterfall", info_y + 2, info_x + 1);
-            printf("\033[%d;%dH  c      colormap", info_y + 3, info_x + 1);
-            printf("\033[%d;%dH  a/s    gain %.1fx", info_y + 4, info_x + 1, ctx->gain);
-            printf("\033[%d;%dH  r/f    smooth %d%%", info_y + 5, info_x + 1, *smoothing_percent);
-            printf("\033[%d;%dH  e/d    hold %.1fs", info_y + 6, info_x + 1, ctx->peak_hold_time);
-            printf("\033[%d;%dH  z      stats", info_y + 7, info_x + 1);
-            printf("\033[%d;%dH  i      info", info_y + 8, info_x + 1);
-            printf("\033[%d;%dH  q/ESC  quit", info_y + 9, info_x + 1);
+            int line = info_y + 2;
+            printf("\033[%d;%dH  w      waterfall", line++, info_x + 1);
+            printf("\033[%d;%dH  p      persistence", line++, info_x + 1);
+            printf("\033[%d;%dH  [/]    persist %.1fs", line++, info_x + 1, ctx->persistence_time);
+            printf("\033[%d;%dH  g      phase scope", line++, info_x + 1);
+            printf("\033[%d;%dH  t      tonal peaks", line++, info_x + 1);
+            printf("\033[%d;%dH  o      octave bands", line++, info_x + 1);
+            printf("\033[%d;%dH  k      fast/slow/Leq", line++, info_x + 1);
+            printf("\033[%d;%dH  c      colormap", line++, info_x + 1);
+            printf("\033[%d;%dH  a/s    gain %.1fx", line++, info_x + 1, ctx->gain);
+            printf("\033[%d;%dH  r/f    smooth %d%%", line++, info_x + 1, *smoothing_percent);
+            printf("\033[%d;%dH  m      avg %s", line++, info_x + 1, spectrum_average_name(ctx->average));
+            printf("\033[%d;%dH  e/d    hold %.1fs", line++, info_x + 1, ctx->peak_hold_time);
+            if (ctx->peak_attack > 0) {
+                printf("\033[%d;%dH  y/h    attack %.0fdB/s", line++, info_x + 1, ctx->peak_attack);
+            } else {
+                printf("\033[%d;%dH  y/h    attack instant", line++, info_x + 1);
+            }
+            printf("\033[%d;%dH  u/j    release %.0fdB/s", line++, info_x + 1, ctx->peak_release);
+            printf("\033[%d;%dH  v      view %s", line++, info_x + 1, ctx->view_names[ctx->view]);
+            printf("\033[%d;%dH  space  pause", line++, info_x + 1);
+            printf("\033[%d;%dH  arrows scroll back", line++, info_x + 1);
+            printf("\033[%d;%dH  z      stats", line++, info_x + 1);
+            printf("\033[%d;%dH  l      loudness%s", line++, info_x + 1,
+                   ctx->loudness_running && !ctx->show_loudness ? " running" : "");
+            printf("\033[%d;%dH  x      reset meters/avg", line++, info_x + 1);
+            printf("\033[%d;%dH         stops hidden meter", line++, info_x + 1);
+            printf("\033[%d;%dH  i      info", line++, info_x + 1);
+            printf("\033[%d;%dH  q/ESC  quit", line++, info_x + 1);
             printf("\033[0m");
             fflush(stdout);
         } else {
@@ -553,14 +1336,31 @@ bool display_handle_input(display_ctx_t *ctx, int *smoothing_percent) {
             for (int y = 0; y < info_h; y++) {
                 mvhline(info_y + y, info_x, ' ', info_w);
             }
-            mvprintw(info_y + 2, info_x + 2, "w      waterfall");
-            mvprintw(info_y + 3, info_x + 2, "c      colormap");
-            mvprintw(info_y + 4, info_x + 2, "a/s    gain");
-            mvprintw(info_y + 5, info_x + 2, "r/f    smooth");
-            mvprintw(info_y + 6, info_x + 2, "e/d    hold");
-            mvprintw(info_y + 7, info_x + 2, "z      stats");
-            mvprintw(info_y + 8, info_x + 2, "i      info");
-            mvprintw(info_y + 9, info_x + 2, "q/ESC  quit");
+            int line = info_y + 2;
+            mvprintw(line++, info_x + 2, "w      waterfall");
+            mvprintw(line++, info_x + 2, "p      persistence");
+            mvprintw(line++, info_x + 2, "[/]    persist time");
+            mvprintw(line++, info_x + 2, "g      phase scope");
+            mvprintw(line++, info_x + 2, "t      tonal peaks");
+            mvprintw(line++, info_x + 2, "o      octave bands");
+            mvprintw(line++, info_x + 2, "k      fast/slow/Leq");
+            mvprintw(line++, info_x + 2, "c      colormap");
+            mvprintw(line++, info_x + 2, "a/s    gain");
+            mvprintw(line++, info_x + 2, "r/f    smooth");
+            mvprintw(line++, info_x + 2, "m      average mode");
+            mvprintw(line++, info_x + 2, "e/d    hold");
+            mvprintw(line++, info_x + 2, "y/h    attack");
+            mvprintw(line++, info_x + 2, "u/j    release");
+            mvprintw(line++, info_x + 2, "v      view");
+            mvprintw(line++, info_x + 2, "space  pause");
+            mvprintw(line++, info_x + 2, "arrows scroll back");
+            mvprintw(line++, info_x + 2, "z      stats");
+            mvprintw(line++, info_x + 2, "l      loudness%s",
+                     ctx->loudness_running && !ctx->show_loudness ? " running" : "");
+            mvprintw(line++, info_x + 2, "x      reset meters/avg");
+            mvprintw(line++, info_x + 2, "       stops hidden meter");
+            mvprintw(line++, info_x + 2, "i      info");
+            mvprintw(line++, info_x + 2, "q/ESC  quit");
         }
     }
 
@@ -0,0 +1,55 @@
+#include "history.h"
+#include <stdlib.h>
+#include <string.h>
+
+int history_init(history_t *history, size_t bins, size_t capacity) {
+    memset(history, 0, sizeof(*history));
+    history->rows = malloc(bins * capacity);
+    history->times = malloc(sizeof(double) * capacity);
+    if (!history->rows || !history->times) {
+        history_shutdown(history);
+        return -1;
+    }
+    history->bins = bins;
+    history->capacity = capacity;
+    return 0;
+}
+
+void history_shutdown(history_t *history) {
+    free(history->rows);
+    free(history->times);
+    memset(history, 0, sizeof(*history));
+}
+
+void history_push(history_t *history, const double *spectrum, double now) {
+    uint8_t *row = history->rows + history->head * history->bins;
+    for (size_t i = 0; i < history->bins; i++) {
+        double v = spectrum[i];
+        if (v < 0.0) v = 0.0;
+        if (v > 1.0) v = 1.0;
+        row[i] = (uint8_t)(v * 255.0 + 0.5);
+    }
+    history->times[history->head] = now;
+    history->head = (history->head + 1) % history->capacity;
+    if (history->count < history->capacity) {
+        history->count++;
+    }
+}
+
+static size_t row_index(const history_t *history, size_t age) {
+    return (history->head + history->capacity - 1 - age) % history->capacity;
+}
+
+const uint8_t *history_row(const history_t *history, size_t age) {
+    if (age >= history->count) {
+        return NULL;
+    }
+    return history->rows + row_index(history, age) * history->bins;
+}
+
+double history_time(const history_t *history, size_t age) {
+    if (age >= history->count) {
+        return 0.0;
+    }
+    return history->times[row_index(history, age)];
+}
@@ -0,0 +1,305 @@
+#include "kitty.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <termios.h>
+#include <unistd.h>
+
+constexpr uint32_t KITTY_QUERY_ID = 31;
+constexpr int KITTY_QUERY_TIMEOUT_MS = 250;
+
+static const char BASE64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static void put_base64(const char *s) {
+    size_t len = strlen(s);
+    for (size_t i = 0; i < len; i += 3) {
+        unsigned v = (unsigned char)s[i] << 16;
+        if (i + 1 < len) v |= (unsigned char)s[i + 1] << 8;
+        if (i + 2 < len) v |= (unsigned char)s[i + 2];
+        putchar(BASE64[(v >> 18) & 63]);
+        putchar(BASE64[(v >> 12) & 63]);
+        putchar(i + 1 < len ? BASE64[(v >> 6) & 63] : '=');
+        putchar(i + 2 < len ? BASE64[v & 63] : '=');
+    }
+}
+
+bool kitty_detect(void) {
+    const char *force = getenv("TSPEC_GRAPHICS");
+    if (force) {
+        return strcmp(force, "kitty") == 0;
+    }
+    const char *term = getenv("TERM");
+    if (term && strstr(term, "kitty")) {
+        return true;
+    }
+    if (getenv("KITTY_WINDOW_ID")) {
+        return true;
+    }
+    const char *program = getenv("TERM_PROGRAM");
+    return program && strcmp(program, "ghostty") == 0;
+}
+
+// Shared memory only works when the terminal runs on this host; allow
+// forcing the temp-file medium (e.g. over ssh with a forwarded /tmp)
+static bool shm_available(void) {
+    const char *medium = getenv("TSPEC_KITTY_MEDIUM");
+    if (medium && strcmp(medium, "file") == 0) {
+        return false;
+    }
+    char name[64];
+    snprintf(name, sizeof(name), "/tspec-probe-%d", (int)getpid());
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        return false;
+    }
+    close(fd);
+    shm_unlink(name);
+    return true;
+}
+
+// Collect the terminal's replies until the DA1 answer ("\033[?...c"), which
+// every terminal sends, or the timeout; true if the graphics query got OK
+static bool read_query_reply(void) {
+    char reply[512];
+    size_t len = 0;
+    struct pollfd pfd = {.fd = STDIN_FILENO, .events = POLLIN};
+    while (len + 1 < sizeof(reply) && poll(&pfd, 1, KITTY_QUERY_TIMEOUT_MS) > 0) {
+        ssize_t n = read(STDIN_FILENO, reply + len, sizeof(reply) - 1 - len);
+        if (n <= 0) break;
+        len += (size_t)n;
+        reply[len] = '\0';
+        const char *da = strstr(reply, "\033[?");
+        if (da && strchr(da, 'c')) break;
+    }
+    reply[len] = '\0';
+
+    char ok[32];
+    snprintf(ok, sizeof(ok), "\033_Gi=%u;OK", KITTY_QUERY_ID);
+    return strstr(reply, ok) != NULL;
+}
+
+// Have the terminal load a 1x1 image through the medium without keeping
+// it. A terminal that only claims kitty support, or one on another host
+// (ssh forwards TERM), never opens the object and would leak one per
+// frame, so only a medium answered with OK is used.
+static bool query_medium(bool shm) {
+    static const uint8_t pixel[3] = {0, 0, 0};
+    char name[256];
+    int fd;
+    if (shm) {
+        snprintf(name, sizeof(name), "/tspec-query-%d", (int)getpid());
+        fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    } else {
+        const char *tmpdir = getenv("TMPDIR");
+        snprintf(name, sizeof(name), "%s/tty-graphics-protocol-tspec-XXXXXX", tmpdir ? tmpdir : "/tmp");
+        fd = mkstemp(name);
+    }
+    if (fd < 0) {
+        return false;
+    }
+    bool written = write(fd, pixel, sizeof(pixel)) == (ssize_t)sizeof(pixel);
+    close(fd);
+
+    bool ok = false;
+    struct termios saved;
+    if (written && isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &saved) == 0) {
+        struct termios raw = saved;
+        raw.c_lflag &= ~(tcflag_t)(ICANON | ECHO);
+        raw.c_cc[VMIN] = 0;
+        raw.c_cc[VTIME] = 0;
+        tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+
+        printf("\033_Gi=%u,s=1,v=1,a=q,f=24,t=%c;", KITTY_QUERY_ID, shm ? 's' : 't');
+        put_base64(name);
+        printf("\033\\\033[c");
+        fflush(stdout);
+        ok = read_query_reply();
+
+        tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+    }
+
+    // The terminal removes what it read; clean up whatever it didn't
+    if (shm) {
+        shm_unlink(name);
+    } else {
+        unlink(name);
+    }
+    return ok;
+}
+
+int kitty_init(kitty_ctx_t *ctx) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->image_id = ((uint32_t)getpid() & 0xffffff) | 1;
+    ctx->use_shm = shm_available() && query_medium(true);
+    if (!ctx->use_shm && !query_medium(false)) {
+        return -1;  // no medium the terminal can read; render with cells
+    }
+    ctx->content = KITTY_IMAGE_NONE;
+    return 0;
+}
+
+void kitty_clear(kitty_ctx_t *ctx) {
+    if (ctx->content != KITTY_IMAGE_NONE) {
+        printf("\033_Ga=d,d=I,i=%u,q=2\033\\", ctx->image_id);
+        fflush(stdout);
+    }
+    ctx->content = KITTY_IMAGE_NONE;
+}
+
+void kitty_shutdown(kitty_ctx_t *ctx) {
+    kitty_clear(ctx);
+    if (ctx->mapped) {
+        munmap(ctx->mapped, ctx->pending_bytes);
+        shm_unlink(ctx->shm_name);
+    }
+    free(ctx->staging);
+    free(ctx->columns);
+    free(ctx->heights);
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+uint8_t *kitty_begin(kitty_ctx_t *ctx, int nrows) {
+    size_t bytes = (size_t)ctx->width * nrows * 4;
+    ctx->pending_bytes = bytes;
+
+    if (ctx->use_shm) {
+        snprintf(ctx->shm_name, sizeof(ctx->shm_name), "/tspec-%d-%u", (int)getpid(), ctx->seq++);
+        int fd = shm_open(ctx->shm_name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd >= 0) {
+            void *map = MAP_FAILED;
+            if (ftruncate(fd, (off_t)bytes) == 0) {
+                map = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+            close(fd);
+            if (map != MAP_FAILED) {
+                ctx->mapped = map;
+                return ctx->mapped;
+            }
+            shm_unlink(ctx->shm_name);
+        }
+        ctx->use_shm = false;  // fall back to temp files for good
+    }
+
+    return ctx->staging;
+}
+
+// Emit one graphics command whose payload is the pending rows; the
+// terminal reads (and removes) the shm object or temp file itself
+static int transmit(kitty_ctx_t *ctx, const char *keys) {
+    char path[256];
+
+    if (ctx->mapped) {
+        munmap(ctx->mapped, ctx->pending_bytes);
+        ctx->mapped = NULL;
+        printf("\033_G%s,f=32,t=s,S=%zu,q=2;", keys, ctx->pending_bytes);
+        put_base64(ctx->shm_name);
+        printf("\033\\");
+        return 0;
+    }
+
+    // kitty only deletes temp files whose path contains this marker
+    const char *tmpdir = getenv("TMPDIR");
+    snprintf(path, sizeof(path), "%s/tty-graphics-protocol-tspec-XXXXXX", tmpdir ? tmpdir : "/tmp");
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        return -1;
+    }
+    ssize_t written = write(fd, ctx->staging, ctx->pending_bytes);
+    close(fd);
+    if (written != (ssize_t)ctx->pending_bytes) {
+        unlink(path);
+        return -1;
+    }
+    printf("\033_G%s,f=32,t=t,S=%zu,q=2;", keys, ctx->pending_bytes);
+    put_base64(path);
+    printf("\033\\");
+    return 0;
+}
+
+// Show image rows [src_y, src_y + src_h) starting px_y pixels below the
+// top of the covered area; zero height removes the placement
+static void place(kitty_ctx_t *ctx, int placement, int src_y, int src_h, int px_y) {
+    if (src_h <= 0) {
+        printf("\033_Ga=d,d=i,i=%u,p=%d,q=2\033\\", ctx->image_id, placement);
+        return;
+    }
+    printf("\033[%d;1H\033_Ga=p,i=%u,p=%d,x=0,y=%d,w=%d,h=%d,Y=%d,z=-1,C=1,q=2\033\\",
+           ctx->top_row + px_y / ctx->cell_h + 1, ctx->image_id, placement,
+           src_y, src_h, ctx->width, px_y % ctx->cell_h);
+}
+
+int kitty_configure(kitty_ctx_t *ctx, int top_row, int cols, int rows, kitty_image_t content) {
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) != 0 ||
+        ws.ws_xpixel == 0 || ws.ws_ypixel == 0 || ws.ws_col == 0 || ws.ws_row == 0) {
+        return -1;
+    }
+    int cell_w = ws.ws_xpixel / ws.ws_col;
+    int cell_h = ws.ws_ypixel / ws.ws_row;
+
+    if (ctx->content == content && ctx->top_row == top_row && ctx->cols == cols &&
+        ctx->rows == rows && ctx->cell_w == cell_w && ctx->cell_h == cell_h) {
+        return 0;
+    }
+
+    kitty_clear(ctx);
+    ctx->top_row = top_row;
+    ctx->cols = cols;
+    ctx->rows = rows;
+    ctx->cell_w = cell_w;
+    ctx->cell_h = cell_h;
+    ctx->width = cols * cell_w;
+    ctx->height = rows * cell_h;
+    ctx->ring_pos = 0;
+    if (ctx->width <= 0 || ctx->height <= 0) {
+        return -1;
+    }
+
+    free(ctx->staging);
+    free(ctx->columns);
+    free(ctx->heights);
+    ctx->staging = malloc((size_t)ctx->width * ctx->height * 4);
+    ctx->columns = malloc(sizeof(float) * ctx->width);
+    ctx->heights = malloc(sizeof(int) * ctx->width);
+    if (!ctx->staging || !ctx->columns || !ctx->heights) {
+        return -1;
+    }
+
+    ctx->content = content;
+    return 1;
+}
+
+int kitty_commit_image(kitty_ctx_t *ctx) {
+    char keys[96];
+    snprintf(keys, sizeof(keys), "a=t,i=%u,s=%d,v=%d", ctx->image_id, ctx->width, ctx->height);
+    if (transmit(ctx, keys) != 0) {
+        return -1;
+    }
+    // A full waterfall image restarts the ring with row 0 on top
+    ctx->ring_pos = 0;
+    place(ctx, 1, 0, ctx->height, 0);
+    if (ctx->content == KITTY_IMAGE_WATERFALL) {
+        place(ctx, 2, 0, 0, 0);
+    }
+    return 0;
+}
+
+int kitty_commit_waterfall_row(kitty_ctx_t *ctx) {
+    // Newest line goes one row above the previous one; the two placements
+    // below show the ring unrolled with the newest line on top
+    ctx->ring_pos = (ctx->ring_pos - 1 + ctx->height) % ctx->height;
+
+    char keys[128];
+    snprintf(keys, sizeof(keys), "a=f,r=1,X=1,i=%u,x=0,y=%d,s=%d,v=1",
+             ctx->image_id, ctx->ring_pos, ctx->width);
+    if (transmit(ctx, keys) != 0) {
+        return -1;
+    }
+    place(ctx, 1, ctx->ring_pos, ctx->height - ctx->ring_pos, 0);
+    place(ctx, 2, 0, ctx->ring_pos, ctx->height - ctx->ring_pos);
+    return 0;
+}
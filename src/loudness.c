@@ -0,0 +1,362 @@
+#include "loudness.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+constexpr double LOUDNESS_ABS_GATE = -70.0;
+constexpr double LOUDNESS_POLL_SECONDS = 0.01;
+constexpr double LOUDNESS_IDLE_POLL_SECONDS = 0.25;  // while the capture ring stays empty
+
+typedef long long loudness_mask_t __attribute__((vector_size(LOUDNESS_LANES * sizeof(long long))));
+
+// Lane-wise max, a macro so no vector crosses a function-call ABI
+#define VMAX(a, b) ((loudness_vec_t)(((loudness_mask_t)(a) & ((a) > (b))) | \
+                                     ((loudness_mask_t)(b) & ~((a) > (b)))))
+
+static double to_lufs(double energy) {
+    return energy > 0.0 ? -0.691 + 10.0 * log10(energy) : -INFINITY;
+}
+
+static int hist_bin(double lufs) {
+    int bin = (int)((lufs - LOUDNESS_ABS_GATE) * 10.0);
+    if (bin < 0) bin = 0;
+    if (bin >= LOUDNESS_HIST_BINS) bin = LOUDNESS_HIST_BINS - 1;
+    return bin;
+}
+
+// BS.1770 channel weighting: surrounds +1.5 dB, LFE excluded
+static double channel_weight(const char *name) {
+    if (strcmp(name, "LFE") == 0) return 0.0;
+    if (strcmp(name, "SL") == 0 || strcmp(name, "SR") == 0 ||
+        strcmp(name, "RL") == 0 || strcmp(name, "RR") == 0) {
+        return 1.41;
+    }
+    return 1.0;
+}
+
+// K-weighting coefficients for any rate, from the analog prototypes
+// behind the 48 kHz tables in BS.1770
+static void design_k_weighting(loudness_ctx_t *ctx, double rate) {
+    double f0 = 1681.974450955533;
+    double gain_db = 3.999843853973347;
+    double q = 0.7071752369554196;
+    double k = tan(M_PI * f0 / rate);
+    double vh = pow(10.0, gain_db / 20.0);
+    double vb = pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+    ctx->shelf_b[0] = (vh + vb * k / q + k * k) / a0;
+    ctx->shelf_b[1] = 2.0 * (k * k - vh) / a0;
+    ctx->shelf_b[2] = (vh - vb * k / q + k * k) / a0;
+    ctx->shelf_a[0] = 1.0;
+    ctx->shelf_a[1] = 2.0 * (k * k - 1.0) / a0;
+    ctx->shelf_a[2] = (1.0 - k / q + k * k) / a0;
+
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = tan(M_PI * f0 / rate);
+    a0 = 1.0 + k / q + k * k;
+    ctx->hp_b[0] = 1.0;
+    ctx->hp_b[1] = -2.0;
+    ctx->hp_b[2] = 1.0;
+    ctx->hp_a[0] = 1.0;
+    ctx->hp_a[1] = 2.0 * (k * k - 1.0) / a0;
+    ctx->hp_a[2] = (1.0 - k / q + k * k) / a0;
+}
+
+// Windowed-sinc interpolator split into polyphase branches; the centre tap
+// falls on phase 0 so that branch passes the input samples through
+static void design_true_peak(loudness_ctx_t *ctx) {
+    constexpr int taps = LOUDNESS_TP_PHASES * LOUDNESS_TP_TAPS;
+    constexpr int centre = taps / 2;
+
+    for (int p = 0; p < LOUDNESS_TP_PHASES; p++) {
+        double sum = 0.0;
+        for (int k = 0; k < LOUDNESS_TP_TAPS; k++) {
+            int n = p + k * LOUDNESS_TP_PHASES;
+            double t = (double)(n - centre) / LOUDNESS_TP_PHASES;
+            double sinc = t == 0.0 ? 1.0 : sin(M_PI * t) / (M_PI * t);
+            double w = 0.42 + 0.5 * cos(M_PI * (n - centre) / centre) +
+                       0.08 * cos(2.0 * M_PI * (n - centre) / centre);  // Blackman
+            ctx->tp_coeffs[p][k] = sinc * w;
+            sum += sinc * w;
+        }
+        for (int k = 0; k < LOUDNESS_TP_TAPS; k++) {
+            ctx->tp_coeffs[p][k] /= sum;  // unity DC gain per branch
+        }
+    }
+}
+
+static void reset_measurements(loudness_ctx_t *ctx) {
+    memset(ctx->blocks, 0, sizeof(ctx->blocks));
+    memset(ctx->tp_blocks, 0, sizeof(ctx->tp_blocks));
+    memset(ctx->hist_integrated, 0, sizeof(ctx->hist_integrated));
+    memset(ctx->hist_range, 0, sizeof(ctx->hist_range));
+    ctx->block_sum = (loudness_vec_t){0};
+    ctx->tp_block_max = (loudness_vec_t){0};
+    ctx->block_fill = 0;
+    ctx->block_pos = 0;
+    ctx->tp_block_pos = 0;
+    ctx->block_count = 0;
+
+    pthread_mutex_lock(&ctx->lock);
+    ctx->reading = (loudness_reading_t){
+        .momentary = -INFINITY,
+        .short_term = -INFINITY,
+        .integrated = -INFINITY,
+        .range = 0.0,
+        .true_peak = -INFINITY,
+        .true_peak_max = -INFINITY,
+    };
+    pthread_mutex_unlock(&ctx->lock);
+}
+
+static void configure(loudness_ctx_t *ctx, uint32_t rate, uint32_t channels) {
+    ctx->sample_rate = rate;
+    ctx->channels = channels;
+    ctx->block_len = rate / 10;
+
+    ctx->weight = (loudness_vec_t){0};
+    for (uint32_t c = 0; c < channels && c < LOUDNESS_LANES; c++) {
+        ctx->weight[c] = channel_weight(ctx->audio->channel_names[c]);
+    }
+
+    design_k_weighting(ctx, rate);
+    ctx->shelf_z1 = ctx->shelf_z2 = (loudness_vec_t){0};
+    ctx->hp_z1 = ctx->hp_z2 = (loudness_vec_t){0};
+    memset(ctx->tp_history, 0, sizeof(ctx->tp_history));
+    ctx->tp_pos = 0;
+
+    reset_measurements(ctx);
+}
+
+// Mean energy of the gated histogram above the relative gate (in LU below
+// the ungated mean); returns -inf when nothing passes
+static double gated_mean(const loudness_ctx_t *ctx, const uint32_t *hist, double relative, int *gate_bin) {
+    double sum = 0.0;
+    uint64_t count = 0;
+    for (int b = 0; b < LOUDNESS_HIST_BINS; b++) {
+        sum += hist[b] * ctx->hist_energy[b];
+        count += hist[b];
+    }
+    if (count == 0) {
+        *gate_bin = LOUDNESS_HIST_BINS;
+        return -INFINITY;
+    }
+    double gate = to_lufs(sum / count) + relative;
+    *gate_bin = gate < LOUDNESS_ABS_GATE ? 0 : hist_bin(gate);
+
+    sum = 0.0;
+    count = 0;
+    for (int b = *gate_bin; b < LOUDNESS_HIST_BINS; b++) {
+        sum += hist[b] * ctx->hist_energy[b];
+        count += hist[b];
+    }
+    return count > 0 ? to_lufs(sum / count) : -INFINITY;
+}
+
+// EBU Tech 3342: spread between the 10th and 95th percentile of gated
+// short-term loudness
+static double loudness_range(const loudness_ctx_t *ctx) {
+    int gate_bin;
+    if (gated_mean(ctx, ctx->hist_range, -20.0, &gate_bin) == -INFINITY) {
+        return 0.0;
+    }
+    uint64_t count = 0;
+    for (int b = gate_bin; b < LOUDNESS_HIST_BINS; b++) {
+        count += ctx->hist_range[b];
+    }
+    uint64_t lo_rank = (uint64_t)(0.10 * (count - 1));
+    uint64_t hi_rank = (uint64_t)(0.95 * (count - 1));
+    int lo = -1, hi = -1;
+    uint64_t seen = 0;
+    for (int b = gate_bin; b < LOUDNESS_HIST_BINS && hi < 0; b++) {
+        seen += ctx->hist_range[b];
+        if (lo < 0 && seen > lo_rank) lo = b;
+        if (seen > hi_rank) hi = b;
+    }
+    return (hi - lo) / 10.0;
+}
+
+static void end_block(loudness_ctx_t *ctx) {
+    loudness_vec_t e = ctx->block_sum * ctx->weight / (double)ctx->block_len;
+    double energy = 0.0;
+    double tp_sq = 0.0;
+    for (size_t c = 0; c < LOUDNESS_LANES; c++) {
+        energy += e[c];
+        if (ctx->tp_block_max[c] > tp_sq) tp_sq = ctx->tp_block_max[c];
+    }
+    ctx->block_sum = (loudness_vec_t){0};
+    ctx->tp_block_max = (loudness_vec_t){0};
+    ctx->block_fill = 0;
+
+    ctx->blocks[ctx->block_pos] = energy;
+    ctx->tp_blocks[ctx->tp_block_pos] = sqrt(tp_sq);
+    ctx->tp_block_pos = (ctx->tp_block_pos + 1) % LOUDNESS_MOMENTARY_BLOCKS;
+    ctx->block_pos = (ctx->block_pos + 1) % LOUDNESS_SHORT_BLOCKS;
+    if (ctx->block_count < LOUDNESS_SHORT_BLOCKS) ctx->block_count++;
+
+    // Windows ending at this block, 100 ms hop
+    double momentary = -INFINITY;
+    double short_term = -INFINITY;
+    double sum = 0.0;
+    double tp = 0.0;
+    for (int i = 1; i <= ctx->block_count; i++) {
+        sum += ctx->blocks[(ctx->block_pos - i + LOUDNESS_SHORT_BLOCKS) % LOUDNESS_SHORT_BLOCKS];
+        if (i == LOUDNESS_MOMENTARY_BLOCKS) {
+            momentary = to_lufs(sum / LOUDNESS_MOMENTARY_BLOCKS);
+        }
+    }
+    if (ctx->block_count == LOUDNESS_SHORT_BLOCKS) {
+        short_term = to_lufs(sum / LOUDNESS_SHORT_BLOCKS);
+    }
+    for (int i = 0; i < LOUDNESS_MOMENTARY_BLOCKS; i++) {
+        if (ctx->tp_blocks[i] > tp) tp = ctx->tp_blocks[i];
+    }
+
+    if (momentary >= LOUDNESS_ABS_GATE) ctx->hist_integrated[hist_bin(momentary)]++;
+    if (short_term >= LOUDNESS_ABS_GATE) ctx->hist_range[hist_bin(short_term)]++;
+
+    int gate_bin;
+    double integrated = gated_mean(ctx, ctx->hist_integrated, -10.0, &gate_bin);
+    double range = loudness_range(ctx);
+    double tp_db = tp > 0.0 ? 20.0 * log10(tp) : -INFINITY;
+
+    pthread_mutex_lock(&ctx->lock);
+    ctx->reading.momentary = momentary;
+    ctx->reading.short_term = short_term;
+    ctx->reading.integrated = integrated;
+    ctx->reading.range = range;
+    ctx->reading.true_peak = tp_db;
+    if (tp_db > ctx->reading.true_peak_max) ctx->reading.true_peak_max = tp_db;
+    pthread_mutex_unlock(&ctx->lock);
+}
+
+static void process(loudness_ctx_t *ctx, size_t count) {
+    const double sb0 = ctx->shelf_b[0], sb1 = ctx->shelf_b[1], sb2 = ctx->shelf_b[2];
+    const double sa1 = ctx->shelf_a[1], sa2 = ctx->shelf_a[2];
+    const double hb0 = ctx->hp_b[0], hb1 = ctx->hp_b[1], hb2 = ctx->hp_b[2];
+    const double ha1 = ctx->hp_a[1], ha2 = ctx->hp_a[2];
+
+    for (size_t i = 0; i < count; i++) {
+        loudness_vec_t x = {0};
+        for (uint32_t c = 0; c < ctx->channels; c++) {
+            x[c] = ctx->scratch[c][i];
+        }
+
+        // K-weighting, one channel per lane
+        loudness_vec_t y = sb0 * x + ctx->shelf_z1;
+        ctx->shelf_z1 = sb1 * x - sa1 * y + ctx->shelf_z2;
+        ctx->shelf_z2 = sb2 * x - sa2 * y;
+        loudness_vec_t k = hb0 * y + ctx->hp_z1;
+        ctx->hp_z1 = hb1 * y - ha1 * k + ctx->hp_z2;
+        ctx->hp_z2 = hb2 * y - ha2 * k;
+        ctx->block_sum += k * k;
+
+        // True peak: newest input lands at both halves of the doubled ring
+        // so each branch reads its taps as one contiguous run
+        ctx->tp_history[ctx->tp_pos] = x;
+        ctx->tp_history[ctx->tp_pos + LOUDNESS_TP_TAPS] = x;
+        ctx->tp_pos = (ctx->tp_pos + 1) % LOUDNESS_TP_TAPS;
+        const loudness_vec_t *window = ctx->tp_history + ctx->tp_pos + LOUDNESS_TP_TAPS - 1;
+        for (int p = 0; p < LOUDNESS_TP_PHASES; p++) {
+            loudness_vec_t acc = {0};
+            for (int t = 0; t < LOUDNESS_TP_TAPS; t++) {
+                acc += ctx->tp_coeffs[p][t] * window[-t];
+            }
+            loudness_vec_t sq = acc * acc;
+            ctx->tp_block_max = VMAX(sq, ctx->tp_block_max);
+        }
+
+        if (++ctx->block_fill == ctx->block_len) {
+            end_block(ctx);
+        }
+    }
+}
+
+static void *loudness_thread(void *arg) {
+    loudness_ctx_t *ctx = arg;
+    const struct timespec pause = {
+        .tv_sec = 0,
+        .tv_nsec = (long)(LOUDNESS_POLL_SECONDS * 1e9),
+    };
+    const struct timespec idle_pause = {
+        .tv_sec = 0,
+        .tv_nsec = (long)(LOUDNESS_IDLE_POLL_SECONDS * 1e9),
+    };
+
+    while (atomic_load(&ctx->running)) {
+        uint32_t rate = audio_get_sample_rate(ctx->audio);
+        uint32_t channels = audio_get_channels(ctx->audio);
+        if (rate != ctx->sample_rate || channels != ctx->channels) {
+            configure(ctx, rate, channels);
+        }
+        if (atomic_exchange(&ctx->reset_requested, false)) {
+            reset_measurements(ctx);
+        }
+
+        // A suspended sink delivers nothing; poll slowly until it resumes
+        size_t count, total = 0;
+        while ((count = audio_read(ctx->audio, &ctx->cursor, ctx->scratch, LOUDNESS_CHUNK)) > 0) {
+            process(ctx, count);
+            total += count;
+        }
+        nanosleep(total > 0 ? &pause : &idle_pause, NULL);
+    }
+    return NULL;
+}
+
+int loudness_init(loudness_ctx_t *ctx, audio_ctx_t *audio) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->audio = audio;
+    ctx->cursor = audio_frames_written(audio);
+    atomic_init(&ctx->running, false);
+    atomic_init(&ctx->reset_requested, false);
+    pthread_mutex_init(&ctx->lock, NULL);
+
+    for (size_t c = 0; c < AUDIO_MAX_CHANNELS; c++) {
+        ctx->scratch[c] = malloc(sizeof(float) * LOUDNESS_CHUNK);
+        if (!ctx->scratch[c]) {
+            loudness_shutdown(ctx);
+            return -1;
+        }
+    }
+    for (int b = 0; b < LOUDNESS_HIST_BINS; b++) {
+        double centre = LOUDNESS_ABS_GATE + (b + 0.5) / 10.0;
+        ctx->hist_energy[b] = pow(10.0, (centre + 0.691) / 10.0);
+    }
+    design_true_peak(ctx);
+    configure(ctx, audio_get_sample_rate(audio), audio_get_channels(audio));
+
+    atomic_store(&ctx->running, true);
+    if (pthread_create(&ctx->thread, NULL, loudness_thread, ctx) != 0) {
+        atomic_store(&ctx->running, false);
+        loudness_shutdown(ctx);
+        return -1;
+    }
+    return 0;
+}
+
+void loudness_shutdown(loudness_ctx_t *ctx) {
+    if (atomic_exchange(&ctx->running, false)) {
+        pthread_join(ctx->thread, NULL);
+    }
+    for (size_t c = 0; c < AUDIO_MAX_CHANNELS; c++) {
+        free(ctx->scratch[c]);
+        ctx->scratch[c] = NULL;
+    }
+    if (ctx->audio) {
+        pthread_mutex_destroy(&ctx->lock);
+        ctx->audio = NULL;
+    }
+}
+
+void loudness_read(loudness_ctx_t *ctx, loudness_reading_t *reading) {
+    pthread_mutex_lock(&ctx->lock);
+    *reading = ctx->reading;
+    pthread_mutex_unlock(&ctx->lock);
+}
+
+void loudness_reset(loudness_ctx_t *ctx) {
+    atomic_store(&ctx->reset_requested, true);
+}
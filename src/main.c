@@ -1,9 +1,17 @@
 #include "audio.h"
 #include "spectrum.h"
 #include "display.h"
+#include "loudness.h"
+#include "octave.h"
+#include "pacer.h"
+#include "recorder.h"
+#include "trigger.h"
+#include <getopt.h>
+#include <poll.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 static volatile sig_atomic_t running = 1;
@@ -13,12 +21,156 @@ static void signal_handler(int sig) {
     running = 0;
 }
 
-int main(void) {
+// Point the display's view list at the current capture channels
+static void set_views(display_ctx_t *display, audio_ctx_t *audio) {
+    uint32_t channels = audio_get_channels(audio);
+    display->num_views = 1 + (int)channels;
+    display->view_names[0] = "mix";
+    for (uint32_t c = 0; c < channels; c++) {
+        display->view_names[c + 1] = audio->channel_names[c];
+    }
+    if (display->view >= display->num_views) {
+        display->view = 0;
+    }
+    display->stereo = audio->stereo;
+}
+
+// Sliding analysis window over the capture stream: every captured frame is
+// seen once, in hops of PERSISTENCE_HOP new frames. Meters and triggers
+// that must not depend on the redraw rate are fed from here, and one
+// transform per hop serves the persistence and phase views and the band
+// and flux rules.
+typedef struct {
+    float samples[AUDIO_MAX_CHANNELS][FFT_SIZE];
+    size_t fill;                // frames of the next hop collected so far
+    uint64_t cursor;            // next capture frame to read
+} stft_t;
+
+// Hand a fired rule mask to the recorder as one capture at frame
+static void fire_triggers(recorder_ctx_t *recorder, const trigger_ctx_t *triggers, unsigned fired,
+                          uint64_t frame) {
+    char label[RECORDER_LABEL_LEN];
+    trigger_label(triggers, fired, label, sizeof(label));
+    recorder_trigger(recorder, frame, label);
+}
+
+// recorder is NULL unless captures are being recorded
+static void feed_hops(stft_t *stft, display_ctx_t *display, audio_ctx_t *audio, spectrum_ctx_t *spectrum,
+                      trigger_ctx_t *triggers, recorder_ctx_t *recorder) {
+    float *window[AUDIO_MAX_CHANNELS];
+    float *tail[AUDIO_MAX_CHANNELS];
+    for (size_t c = 0; c < AUDIO_MAX_CHANNELS; c++) {
+        window[c] = stft->samples[c];
+    }
+    for (;;) {
+        for (size_t c = 0; c < AUDIO_MAX_CHANNELS; c++) {
+            tail[c] = stft->samples[c] + FFT_SIZE - PERSISTENCE_HOP + stft->fill;
+        }
+        size_t n = audio_read(audio, &stft->cursor, tail, PERSISTENCE_HOP - stft->fill);
+        stft->fill += n;
+        if (stft->fill < PERSISTENCE_HOP) {
+            break;
+        }
+
+        uint64_t hop_start = stft->cursor - PERSISTENCE_HOP;
+        int rate = (int)audio_get_sample_rate(audio);
+        const float *hop[AUDIO_MAX_CHANNELS];
+        for (size_t c = 0; c < AUDIO_MAX_CHANNELS; c++) {
+            hop[c] = stft->samples[c] + FFT_SIZE - PERSISTENCE_HOP;
+        }
+
+        // Stats and phase use the front pair (or the single channel for mono)
+        const float *left = hop[0];
+        const float *right = audio->stereo ? hop[1] : left;
+        display_update_stats(display, left, right, PERSISTENCE_HOP);
+
+        bool persistence = display->persistence_mode && !display->paused;
+        bool spectral = recorder && triggers->spectral;
+        if (persistence || display->phase_mode || spectral) {
+            spectrum_analyze(spectrum, (const float *const *)window, FFT_SIZE);
+        }
+        if (recorder) {
+            size_t offset = 0;
+            unsigned fired = trigger_scan(triggers, hop, spectrum->channels, PERSISTENCE_HOP, rate, &offset);
+            if (fired) {
+                fire_triggers(recorder, triggers, fired, hop_start + offset);
+            }
+            fired = spectral ? trigger_eval(triggers, spectrum_levels(spectrum, 0), SPECTRUM_BINS, rate) : 0;
+            if (fired) {
+                fire_triggers(recorder, triggers, fired, hop_start);
+            }
+        }
+        if (persistence) {
+            display_add_persistence(display, spectrum_levels(spectrum, display->view), SPECTRUM_BINS);
+        }
+        if (display->phase_mode) {
+            size_t pair = audio->stereo && spectrum->channels > 1 ? 1 : 0;
+            display_update_phase(display, left, right, PERSISTENCE_HOP, spectrum_channel_bins(spectrum, 0),
+                                 spectrum_channel_bins(spectrum, pair), SPECTRUM_BINS);
+        }
+        for (size_t c = 0; c < spectrum->channels; c++) {
+            memmove(stft->samples[c], stft->samples[c] + PERSISTENCE_HOP,
+                    sizeof(float) * (FFT_SIZE - PERSISTENCE_HOP));
+        }
+        stft->fill = 0;
+    }
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [-r DIR] [-t RULE]... [-b SECONDS] [-a SECONDS]\n"
+            "  -r DIR      record triggered captures as WAV files into DIR\n"
+            "  -t RULE     trigger rule, repeatable:\n"
+            "                level:DBFS        sample peak above DBFS\n"
+            "                band:LO-HI:DB     power between LO and HI Hz above DB\n"
+            "                flux:DB           mean per-bin rise between hops above DB\n"
+            "                each rule fires once per crossing, not while it stays above\n"
+            "  -b SECONDS  audio kept before the trigger (default 2)\n"
+            "  -a SECONDS  audio kept after the trigger (default 2)\n",
+            prog);
+}
+
+int main(int argc, char **argv) {
     audio_ctx_t audio = {0};
     spectrum_ctx_t spectrum = {0};
     display_ctx_t display = {0};
+    loudness_ctx_t loudness = {0};
+    octave_ctx_t octave = {0};
+    recorder_ctx_t recorder = {0};
+    trigger_ctx_t triggers = {0};
+    const char *record_dir = NULL;
+    double pre_seconds = 2.0;
+    double post_seconds = 2.0;
     int ret = EXIT_FAILURE;
 
+    int opt;
+    while ((opt = getopt(argc, argv, "r:t:b:a:h")) != -1) {
+        switch (opt) {
+            case 'r':
+                record_dir = optarg;
+                break;
+            case 't':
+                if (trigger_add_rule(&triggers, optarg) != 0) {
+                    fprintf(stderr, "Bad trigger rule: %s\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'b':
+                pre_seconds = atof(optarg);
+                break;
+            case 'a':
+                post_seconds = atof(optarg);
+                break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    if ((record_dir != NULL) != (triggers.count > 0) || pre_seconds < 0.0 || post_seconds < 0.0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
 
@@ -28,48 +180,151 @@ int main(void) {
         goto cleanup;
     }
 
-    if (spectrum_init(&spectrum) != 0) {
+    if (spectrum_init(&spectrum, audio_get_channels(&audio)) != 0) {
         fprintf(stderr, "Failed to initialize spectrum analyzer\n");
         goto cleanup;
     }
 
+    if (record_dir && recorder_init(&recorder, &audio, record_dir, pre_seconds, post_seconds) != 0) {
+        fprintf(stderr, "Failed to initialize recorder\n");
+        goto cleanup;
+    }
+
     if (display_init(&display) != 0) {
         fprintf(stderr, "Failed to initialize display\n");
         goto cleanup;
     }
     display.sample_rate = audio_get_sample_rate(&audio);
-    display.stereo = audio.stereo;
+    set_views(&display, &audio);
 
-    float samples_l[FFT_SIZE];
-    float samples_r[FFT_SIZE];
-    float samples_mono[FFT_SIZE];
+    static float samples[AUDIO_MAX_CHANNELS][FFT_SIZE];
+    float *channels[AUDIO_MAX_CHANNELS];
+    for (size_t c = 0; c < AUDIO_MAX_CHANNELS; c++) {
+        channels[c] = samples[c];
+    }
+    uint64_t analyzed = audio_frames_written(&audio);  // capture position of the last transform
     int smoothing_percent = 80;
+    static stft_t stft;
+    stft.cursor = audio_frames_written(&audio);
+
+    pacer_ctx_t pacer;
+    pacer_init(&pacer);
+    struct pollfd fds[2] = {
+        { .fd = STDIN_FILENO, .events = POLLIN },
+        { .fd = audio_wake_fd(&audio), .events = POLLIN },
+    };
 
     while (running && audio.running) {
-        audio_get_samples(&audio, samples_l, samples_r, FFT_SIZE);
+        // Sleep until the next frame, a key press, or audio leaving silence
+        fds[0].revents = 0;
+        fds[1].revents = 0;
+        if (poll(fds, 2, pacer_timeout_ms(&pacer)) > 0 && (fds[1].revents & POLLIN)) {
+            audio_ack_wake(&audio);
+            pacer_set_idle(&pacer, false);
+        }
+        if (pacer_timeout_ms(&pacer) > 0 && !(fds[0].revents & POLLIN)) {
+            continue;
+        }
+        pacer_begin_frame(&pacer);
 
-        // Mix to mono for spectrum analysis
-        for (size_t i = 0; i < FFT_SIZE; i++) {
-            samples_mono[i] = (samples_l[i] + samples_r[i]) * 0.5f;
+        // Re-plan if the stream renegotiated to a different channel count
+        if (audio_get_channels(&audio) != spectrum.channels) {
+            spectrum_shutdown(&spectrum);
+            if (spectrum_init(&spectrum, audio_get_channels(&audio)) != 0) {
+                goto cleanup;
+            }
+            set_views(&display, &audio);
         }
 
-        spectrum_process(&spectrum, samples_mono, FFT_SIZE);
+        // Stats, phase, triggers and the density view need every hop, not
+        // one window per redraw
+        feed_hops(&stft, &display, &audio, &spectrum, &triggers, record_dir ? &recorder : NULL);
+
+        // The average advances by the audio captured since the last frame
+        uint64_t written = audio_frames_written(&audio);
+        double elapsed = (double)(written - analyzed) / audio_get_sample_rate(&audio);
+        analyzed = written;
+        audio_get_samples(&audio, channels, FFT_SIZE);
+
         spectrum_set_smoothing(&spectrum, smoothing_percent / 100.0);
+        if (spectrum_set_average(&spectrum, display.average) != 0) {
+            display.average = spectrum.mode;
+        }
+        spectrum_process(&spectrum, (const float *const *)channels, FFT_SIZE, elapsed);
 
-        display_update_stats(&display, samples_l, samples_r, FFT_SIZE);
-        display_update(&display, spectrum.smoothed, SPECTRUM_BINS);
+        // Track peaks in this frame's transform; the averaged view would hold
+        // stale peaks under max hold
+        if (display.show_tonal) {
+            display_update_tonal(&display, spectrum_levels(&spectrum, display.view), SPECTRUM_BINS);
+        }
+
+        if (record_dir) {
+            bool recording = recorder_active(&recorder);
+            if (recording != display.recording) {
+                display.recording = recording;
+                display.idle_drawn = false;
+            }
+        }
+
+        // The filter bank runs only while its bars are shown
+        if (display.octave_fraction != octave.fraction) {
+            octave_shutdown(&octave);
+            if (display.octave_fraction > 0 && octave_init(&octave, &audio, display.octave_fraction) != 0) {
+                display.octave_fraction = 0;
+            }
+        }
+        if (octave.fraction > 0) {
+            double band_levels[OCTAVE_MAX_BANDS], band_centres[OCTAVE_MAX_BANDS];
+            int count = octave_read(&octave, display.octave_weighting, band_levels, band_centres);
+            display_set_bands(&display, band_levels, band_centres, count);
+        }
+
+        // The loudness meter starts with its row but keeps measuring while
+        // hidden, so toggling the row never loses an R128 run; only a reset
+        // with the row hidden stops it
+        if (display.show_loudness && !loudness.audio && loudness_init(&loudness, &audio) != 0) {
+            display.show_loudness = false;
+        }
+
+        if (display.reset_requested) {
+            if (display.show_loudness) {
+                loudness_reset(&loudness);
+            } else {
+                loudness_shutdown(&loudness);
+            }
+            octave_reset(&octave);
+            spectrum_reset_average(&spectrum);
+            display.reset_requested = false;
+        }
+        display.loudness_running = loudness.audio != NULL;
+        if (loudness.audio) {
+            loudness_read(&loudness, &display.loudness);
+        }
+
+        double render_start = pacer_now();
+        display_update(&display, spectrum_view(&spectrum, display.view), SPECTRUM_BINS, analyzed);
 
         if (!display_handle_input(&display, &smoothing_percent)) {
             break;
         }
 
-        usleep(16667);  // ~60 FPS
+        // Drop to the idle rate once silent and decayed, and let the
+        // capture thread wake us on the first non-silent block
+        pacer_end_frame(&pacer, pacer_now() - render_start);
+        pacer_set_idle(&pacer, display_is_idle(&display));
+        if (pacer.idle) {
+            audio_arm_wake(&audio);
+        }
     }
 
     ret = EXIT_SUCCESS;
 
 cleanup:
     display_shutdown(&display);
+    recorder_shutdown(&recorder);
+    trigger_shutdown(&triggers);
+    octave_shutdown(&octave);
+    loudness_shutdown(&loudness);
     spectrum_shutdown(&spectrum);
     audio_shutdown(&audio);
 
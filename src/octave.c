@@ -0,0 +1,335 @@
+#include "octave.h"
+#include <complex.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+constexpr double OCTAVE_RATIO = 1.9952623149688795;  // G = 10^(3/10), base-ten octave
+constexpr double OCTAVE_POLL_SECONDS = 0.01;
+constexpr double OCTAVE_IDLE_POLL_SECONDS = 0.25;  // while the capture ring stays empty
+constexpr double OCTAVE_EDGE_LIMIT = 0.49;  // highest designable band edge, fraction of the rate
+
+// R10 preferred numbers used for nominal mid-band frequencies
+static const double NOMINAL[] = {1.0, 1.25, 1.6, 2.0, 2.5, 3.15, 4.0, 5.0, 6.3, 8.0, 10.0};
+
+// Band-pass biquads from a 3rd-order Butterworth low-pass prototype:
+// analog LP->BP on prewarped edges, then the bilinear transform. Each
+// section has its zeros at DC and Nyquist and unity gain at mid-band.
+static void design_band(octave_band_t *band, double f1, double f2, double fs) {
+    constexpr int order = OCTAVE_SECTIONS;
+    double w1 = 2.0 * fs * tan(M_PI * f1 / fs);
+    double w2 = 2.0 * fs * tan(M_PI * f2 / fs);
+    double w0 = sqrt(w1 * w2);
+    double bw = w2 - w1;
+    double centre = 2.0 * atan(w0 / (2.0 * fs));
+
+    int n = 0;
+    double complex e1 = cexp(-I * centre), e2 = cexp(-2.0 * I * centre);
+    for (int k = 0; k < order && n < OCTAVE_SECTIONS; k++) {
+        double complex p = cexp(I * M_PI * (2 * k + order + 1) / (2.0 * order));
+        double complex half = p * bw / 2.0;
+        double complex disc = csqrt(half * half - w0 * w0);
+        double complex roots[2] = {half + disc, half - disc};
+        double complex z[2];
+        for (int r = 0; r < 2; r++) {
+            z[r] = (2.0 * fs + roots[r]) / (2.0 * fs - roots[r]);
+        }
+
+        // The real prototype pole of a band wider than 2 w0 splits into two
+        // real poles, which share one section instead of a conjugate pair
+        double a1[2], a2[2];
+        int sections = 0;
+        if (fabs(cimag(z[0])) < 1e-9 && fabs(cimag(z[1])) < 1e-9) {
+            a1[sections] = -(creal(z[0]) + creal(z[1]));
+            a2[sections++] = creal(z[0]) * creal(z[1]);
+        } else {
+            for (int r = 0; r < 2; r++) {
+                if (cimag(z[r]) <= 0.0) continue;
+                a1[sections] = -2.0 * creal(z[r]);
+                a2[sections++] = creal(z[r]) * creal(z[r]) + cimag(z[r]) * cimag(z[r]);
+            }
+        }
+
+        for (int i = 0; i < sections && n < OCTAVE_SECTIONS; i++) {
+            octave_biquad_t *s = &band->sections[n++];
+            s->a1 = a1[i];
+            s->a2 = a2[i];
+            double gain = cabs((1.0 - e2) / (1.0 + s->a1 * e1 + s->a2 * e2));
+            s->b0 = 1.0 / gain;
+            s->b1 = 0.0;
+            s->b2 = -1.0 / gain;
+            s->z1 = s->z2 = 0.0;
+        }
+    }
+}
+
+// Windowed-sinc half-band low-pass; every other tap is zero
+static void design_halfband(double *h) {
+    constexpr int centre = OCTAVE_HALFBAND_TAPS / 2;
+    double sum = 0.0;
+    for (int i = 0; i < OCTAVE_HALFBAND_TAPS; i++) {
+        double t = (i - centre) / 2.0;
+        double sinc = t == 0.0 ? 1.0 : sin(M_PI * t) / (M_PI * t);
+        double w = 0.42 - 0.5 * cos(2.0 * M_PI * i / (OCTAVE_HALFBAND_TAPS - 1)) +
+                   0.08 * cos(4.0 * M_PI * i / (OCTAVE_HALFBAND_TAPS - 1));  // Blackman
+        h[i] = sinc * w;
+        sum += h[i];
+    }
+    for (int i = 0; i < OCTAVE_HALFBAND_TAPS; i++) {
+        h[i] /= sum;
+    }
+}
+
+static void configure(octave_ctx_t *ctx, uint32_t rate, uint32_t channels) {
+    ctx->sample_rate = rate;
+    ctx->channels = channels;
+    ctx->num_bands = 0;
+    ctx->num_stages = 1;
+    memset(ctx->decimators, 0, sizeof(ctx->decimators));
+
+    // IEC 61260-1 mid-band frequencies: G^(x/b) for odd b, G^((2x+1)/(2b)) for even b
+    int b = ctx->fraction;
+    for (int x = -6 * b; x <= 5 * b && ctx->num_bands < OCTAVE_MAX_BANDS; x++) {
+        double exponent = b % 2 ? (double)x / b : (2.0 * x + 1.0) / (2.0 * b);
+        double fm = 1000.0 * pow(OCTAVE_RATIO, exponent);
+        double f1 = fm * pow(OCTAVE_RATIO, -1.0 / (2.0 * b));
+        double f2 = fm * pow(OCTAVE_RATIO, 1.0 / (2.0 * b));
+        if (fm < OCTAVE_LOW_HZ || fm > OCTAVE_HIGH_HZ || fm >= 0.5 * rate) continue;
+        // Top bands reach past Nyquist at 44.1/48 kHz; pull the upper edge in
+        // so they are still shown, narrower than nominal
+        f2 = fmin(f2, OCTAVE_EDGE_LIMIT * rate);
+        if (f1 >= f2) continue;
+
+        // Lowest rate that still holds the band with room for the decimators
+        int stage = 0;
+        while (stage + 1 < OCTAVE_MAX_STAGES && f2 < OCTAVE_STAGE_PASS * rate / (1 << (stage + 1))) {
+            stage++;
+        }
+        octave_band_t *band = &ctx->bands[ctx->num_bands++];
+        memset(band, 0, sizeof(*band));
+        band->centre = fm;
+        band->stage = stage;
+        design_band(band, f1, f2, (double)rate / (1 << stage));
+        if (stage + 1 > ctx->num_stages) ctx->num_stages = stage + 1;
+    }
+
+    for (int s = 0; s < ctx->num_stages; s++) {
+        double stage_rate = (double)rate / (1 << s);
+        ctx->fast_coeff[s] = 1.0 - exp(-1.0 / (OCTAVE_FAST_TAU * stage_rate));
+        ctx->slow_coeff[s] = 1.0 - exp(-1.0 / (OCTAVE_SLOW_TAU * stage_rate));
+    }
+
+    pthread_mutex_lock(&ctx->lock);
+    for (int i = 0; i < ctx->num_bands; i++) {
+        ctx->centres[i] = ctx->bands[i].centre;
+        for (int w = 0; w < OCTAVE_WEIGHTINGS; w++) {
+            ctx->levels[w][i] = -INFINITY;
+        }
+    }
+    ctx->published_bands = ctx->num_bands;
+    pthread_mutex_unlock(&ctx->lock);
+}
+
+// Half-band filter and drop every other sample; returns outputs written
+static size_t decimate(octave_ctx_t *ctx, octave_decimator_t *d, const double *in, size_t count, double *out) {
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++) {
+        d->history[d->pos] = in[i];
+        d->history[d->pos + OCTAVE_HALFBAND_TAPS] = in[i];
+        d->pos = (d->pos + 1) % OCTAVE_HALFBAND_TAPS;
+        d->odd = !d->odd;
+        if (d->odd) continue;
+
+        const double *window = d->history + d->pos;
+        double acc = 0.0;
+        for (int k = 0; k < OCTAVE_HALFBAND_TAPS; k++) {
+            acc += ctx->halfband[k] * window[k];
+        }
+        out[n++] = acc;
+    }
+    return n;
+}
+
+static void process(octave_ctx_t *ctx, size_t count) {
+    if (ctx->channels == 0) return;
+
+    size_t lengths[OCTAVE_MAX_STAGES];
+    double *top = ctx->stage_buf[0];
+    double norm = 1.0 / ctx->channels;
+    for (size_t i = 0; i < count; i++) {
+        double sum = 0.0;
+        for (uint32_t c = 0; c < ctx->channels; c++) {
+            sum += ctx->scratch[c][i];
+        }
+        top[i] = sum * norm;
+    }
+    lengths[0] = count;
+    for (int s = 1; s < ctx->num_stages; s++) {
+        lengths[s] = decimate(ctx, &ctx->decimators[s - 1], ctx->stage_buf[s - 1], lengths[s - 1],
+                              ctx->stage_buf[s]);
+    }
+
+    for (int b = 0; b < ctx->num_bands; b++) {
+        octave_band_t *band = &ctx->bands[b];
+        const double *x = ctx->stage_buf[band->stage];
+        size_t n = lengths[band->stage];
+        double fast_k = ctx->fast_coeff[band->stage];
+        double slow_k = ctx->slow_coeff[band->stage];
+        double fast = band->fast, slow = band->slow, sum = 0.0;
+
+        for (size_t i = 0; i < n; i++) {
+            double y = x[i];
+            for (int k = 0; k < OCTAVE_SECTIONS; k++) {
+                octave_biquad_t *s = &band->sections[k];
+                double out = s->b0 * y + s->z1;
+                s->z1 = s->b1 * y - s->a1 * out + s->z2;
+                s->z2 = s->b2 * y - s->a2 * out;
+                y = out;
+            }
+            double sq = y * y;
+            fast += fast_k * (sq - fast);
+            slow += slow_k * (sq - slow);
+            sum += sq;
+        }
+        band->fast = fast;
+        band->slow = slow;
+        band->sum += sum;
+        band->count += n;
+    }
+
+    // Mean square to dB with a full-scale sine at 0 dB
+    pthread_mutex_lock(&ctx->lock);
+    for (int b = 0; b < ctx->num_bands; b++) {
+        const octave_band_t *band = &ctx->bands[b];
+        double leq = band->count ? band->sum / band->count : 0.0;
+        ctx->levels[OCTAVE_FAST][b] = 10.0 * log10(2.0 * band->fast + 1e-20);
+        ctx->levels[OCTAVE_SLOW][b] = 10.0 * log10(2.0 * band->slow + 1e-20);
+        ctx->levels[OCTAVE_LEQ][b] = 10.0 * log10(2.0 * leq + 1e-20);
+    }
+    pthread_mutex_unlock(&ctx->lock);
+}
+
+static void *octave_thread(void *arg) {
+    octave_ctx_t *ctx = arg;
+    const struct timespec pause = {
+        .tv_sec = 0,
+        .tv_nsec = (long)(OCTAVE_POLL_SECONDS * 1e9),
+    };
+    const struct timespec idle_pause = {
+        .tv_sec = 0,
+        .tv_nsec = (long)(OCTAVE_IDLE_POLL_SECONDS * 1e9),
+    };
+
+    while (atomic_load(&ctx->running)) {
+        uint32_t rate = audio_get_sample_rate(ctx->audio);
+        uint32_t channels = audio_get_channels(ctx->audio);
+        if (rate != ctx->sample_rate || channels != ctx->channels) {
+            configure(ctx, rate, channels);
+        }
+        if (atomic_exchange(&ctx->reset_requested, false)) {
+            for (int b = 0; b < ctx->num_bands; b++) {
+                ctx->bands[b].sum = 0.0;
+                ctx->bands[b].count = 0;
+            }
+        }
+
+        // A suspended sink delivers nothing; poll slowly until it resumes
+        size_t count, total = 0;
+        while ((count = audio_read(ctx->audio, &ctx->cursor, ctx->scratch, OCTAVE_CHUNK)) > 0) {
+            process(ctx, count);
+            total += count;
+        }
+        nanosleep(total > 0 ? &pause : &idle_pause, NULL);
+    }
+    return NULL;
+}
+
+int octave_init(octave_ctx_t *ctx, audio_ctx_t *audio, int fraction) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->audio = audio;
+    ctx->fraction = fraction;
+    ctx->cursor = audio_frames_written(audio);
+    atomic_init(&ctx->running, false);
+    atomic_init(&ctx->reset_requested, false);
+    pthread_mutex_init(&ctx->lock, NULL);
+
+    for (size_t c = 0; c < AUDIO_MAX_CHANNELS; c++) {
+        ctx->scratch[c] = malloc(sizeof(float) * OCTAVE_CHUNK);
+        if (!ctx->scratch[c]) {
+            octave_shutdown(ctx);
+            return -1;
+        }
+    }
+    for (int s = 0; s < OCTAVE_MAX_STAGES; s++) {
+        ctx->stage_buf[s] = malloc(sizeof(double) * OCTAVE_CHUNK);
+        if (!ctx->stage_buf[s]) {
+            octave_shutdown(ctx);
+            return -1;
+        }
+    }
+    design_halfband(ctx->halfband);
+    configure(ctx, audio_get_sample_rate(audio), audio_get_channels(audio));
+
+    atomic_store(&ctx->running, true);
+    if (pthread_create(&ctx->thread, NULL, octave_thread, ctx) != 0) {
+        atomic_store(&ctx->running, false);
+        octave_shutdown(ctx);
+        return -1;
+    }
+    return 0;
+}
+
+void octave_shutdown(octave_ctx_t *ctx) {
+    if (atomic_exchange(&ctx->running, false)) {
+        pthread_join(ctx->thread, NULL);
+    }
+    for (size_t c = 0; c < AUDIO_MAX_CHANNELS; c++) {
+        free(ctx->scratch[c]);
+        ctx->scratch[c] = NULL;
+    }
+    for (int s = 0; s < OCTAVE_MAX_STAGES; s++) {
+        free(ctx->stage_buf[s]);
+        ctx->stage_buf[s] = NULL;
+    }
+    if (ctx->audio) {
+        pthread_mutex_destroy(&ctx->lock);
+        ctx->audio = NULL;
+    }
+    ctx->fraction = 0;
+}
+
+int octave_read(octave_ctx_t *ctx, octave_weighting_t weighting, double *levels, double *centres) {
+    pthread_mutex_lock(&ctx->lock);
+    int count = ctx->published_bands;
+    memcpy(levels, ctx->levels[weighting], sizeof(double) * count);
+    memcpy(centres, ctx->centres, sizeof(double) * count);
+    pthread_mutex_unlock(&ctx->lock);
+    return count;
+}
+
+void octave_reset(octave_ctx_t *ctx) {
+    atomic_store(&ctx->reset_requested, true);
+}
+
+void octave_band_label(double centre, int fraction, char *buf, size_t size) {
+    double decade = pow(10.0, floor(log10(centre)));
+    double value = centre;
+
+    // 1/1 and 1/3 octave centres have R10 nominal names; finer bands get 3 digits
+    if (fraction == 1 || fraction == 3) {
+        double mantissa = centre / decade;
+        double best = NOMINAL[0];
+        for (size_t i = 1; i < sizeof(NOMINAL) / sizeof(NOMINAL[0]); i++) {
+            if (fabs(NOMINAL[i] - mantissa) < fabs(best - mantissa)) best = NOMINAL[i];
+        }
+        value = best * decade;
+    }
+
+    if (value >= 1000.0) {
+        snprintf(buf, size, "%.3gk", value / 1000.0);
+    } else {
+        snprintf(buf, size, "%.3g", value);
+    }
+}
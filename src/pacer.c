@@ -0,0 +1,73 @@
+#include "pacer.h"
+#include <math.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+double pacer_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double frame_interval(const pacer_ctx_t *ctx) {
+    return 1.0 / (ctx->idle ? PACER_IDLE_FPS : ctx->fps);
+}
+
+// Bytes written to the terminal that it has not consumed yet
+static size_t output_queue(void) {
+    int queued = 0;
+    if (ioctl(STDOUT_FILENO, TIOCOUTQ, &queued) != 0 || queued < 0) {
+        return 0;
+    }
+    return (size_t)queued;
+}
+
+void pacer_init(pacer_ctx_t *ctx) {
+    double now = pacer_now();
+    ctx->fps = PACER_ACTIVE_FPS;
+    ctx->next_frame = now;
+    ctx->last_frame = now;
+    ctx->frame_dt = 1.0 / PACER_ACTIVE_FPS;
+    ctx->idle = false;
+}
+
+int pacer_timeout_ms(const pacer_ctx_t *ctx) {
+    double wait = ctx->next_frame - pacer_now();
+    if (wait <= 0.0) return 0;
+    return (int)ceil(wait * 1000.0);
+}
+
+void pacer_begin_frame(pacer_ctx_t *ctx) {
+    double now = pacer_now();
+    ctx->frame_dt = now - ctx->last_frame;
+    ctx->last_frame = now;
+}
+
+void pacer_end_frame(pacer_ctx_t *ctx, double render_seconds) {
+    // Back off quickly while the terminal can't keep up (slow writes or a
+    // growing output queue), recover gradually once it drains
+    double budget = PACER_BUSY_FRACTION / ctx->fps;
+    if (render_seconds > budget || output_queue() > PACER_OUTQ_LIMIT) {
+        ctx->fps *= 0.7;
+        if (ctx->fps < PACER_MIN_FPS) ctx->fps = PACER_MIN_FPS;
+    } else if (ctx->fps < PACER_ACTIVE_FPS) {
+        ctx->fps += (PACER_ACTIVE_FPS - ctx->fps) * 0.05 + 0.1;
+        if (ctx->fps > PACER_ACTIVE_FPS) ctx->fps = PACER_ACTIVE_FPS;
+    }
+
+    // Don't try to catch up on missed frames
+    double now = pacer_now();
+    ctx->next_frame = ctx->last_frame + frame_interval(ctx);
+    if (ctx->next_frame < now) ctx->next_frame = now;
+}
+
+void pacer_set_idle(pacer_ctx_t *ctx, bool idle) {
+    if (ctx->idle == idle) return;
+    ctx->idle = idle;
+    if (idle) {
+        ctx->next_frame = ctx->last_frame + frame_interval(ctx);
+    } else {
+        ctx->next_frame = pacer_now();  // resume immediately
+    }
+}
@@ -0,0 +1,157 @@
+#include "peaks.h"
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef float v8f __attribute__((vector_size(PEAKS_LANES * sizeof(float))));
+typedef int v8i __attribute__((vector_size(PEAKS_LANES * sizeof(int))));
+
+// Rebase deadlines before float spacing near (now - epoch) exceeds ~1 ms
+constexpr double PEAKS_REBASE_SECONDS = 1024.0;
+
+// Lane-wise mask ? a : b (a macro, so no vector values cross a call ABI)
+#define SELECT_V8F(mask, a, b) ((v8f)(((v8i)(a) & (mask)) | ((v8i)(b) & ~(mask))))
+
+static size_t padded(size_t count) {
+    return (count + PEAKS_LANES - 1) / PEAKS_LANES * PEAKS_LANES;
+}
+
+float *peaks_alloc_levels(size_t capacity) {
+    size_t bytes = padded(capacity) * sizeof(float);
+    bytes = (bytes + PEAKS_ALIGN - 1) / PEAKS_ALIGN * PEAKS_ALIGN;
+    float *levels = aligned_alloc(PEAKS_ALIGN, bytes);
+    if (levels) {
+        memset(levels, 0, bytes);
+    }
+    return levels;
+}
+
+int peaks_init(peaks_t *peaks, size_t capacity, double now) {
+    memset(peaks, 0, sizeof(*peaks));
+    peaks->capacity = padded(capacity);
+    peaks->value = peaks_alloc_levels(peaks->capacity);
+    peaks->hold_until = peaks_alloc_levels(peaks->capacity);
+    peaks->epoch = now;
+
+    if (!peaks->value || !peaks->hold_until) {
+        peaks_shutdown(peaks);
+        return -1;
+    }
+    peaks->count = capacity;
+    return 0;
+}
+
+void peaks_shutdown(peaks_t *peaks) {
+    free(peaks->value);
+    free(peaks->hold_until);
+    memset(peaks, 0, sizeof(*peaks));
+}
+
+void peaks_reset(peaks_t *peaks, size_t count) {
+    if (count > peaks->capacity) count = peaks->capacity;
+    peaks->count = count;
+    memset(peaks->value, 0, peaks->capacity * sizeof(float));
+    memset(peaks->hold_until, 0, peaks->capacity * sizeof(float));
+}
+
+int peaks_reserve(peaks_t *peaks, size_t capacity) {
+    if (capacity <= peaks->capacity) return 0;
+    capacity = padded(capacity);
+    float *value = peaks_alloc_levels(capacity);
+    float *hold_until = peaks_alloc_levels(capacity);
+    if (!value || !hold_until) {
+        free(value);
+        free(hold_until);
+        return -1;
+    }
+    memcpy(value, peaks->value, peaks->capacity * sizeof(float));
+    memcpy(hold_until, peaks->hold_until, peaks->capacity * sizeof(float));
+    free(peaks->value);
+    free(peaks->hold_until);
+    peaks->value = value;
+    peaks->hold_until = hold_until;
+    peaks->capacity = capacity;
+    return 0;
+}
+
+void peaks_remap(peaks_t *peaks, size_t count) {
+    if (count > peaks->capacity) count = peaks->capacity;
+    size_t old = peaks->count;
+    float *value = peaks->value, *until = peaks->hold_until;
+
+    if (old == 0 || count == 0) {
+        peaks_reset(peaks, count);
+        return;
+    }
+    if (count < old) {
+        // Destination j reads sources at or after j, so walk forward in place
+        for (size_t j = 0; j < count; j++) {
+            size_t lo = j * old / count;
+            size_t hi = (j + 1) * old / count;
+            if (hi <= lo) hi = lo + 1;
+            size_t best = lo;
+            for (size_t i = lo + 1; i < hi; i++) {
+                if (value[i] > value[best]) best = i;
+            }
+            value[j] = value[best];
+            until[j] = until[best];
+        }
+    } else if (count > old) {
+        // Destination j reads a source at or before j, so walk backward
+        for (size_t j = count; j-- > 0;) {
+            size_t src = count > 1 ? (j * (old - 1) + (count - 1) / 2) / (count - 1) : 0;
+            value[j] = value[src];
+            until[j] = until[src];
+        }
+    }
+
+    // Lanes past the new count must stay at rest for the padded update
+    size_t tail = peaks->capacity - count;
+    memset(value + count, 0, tail * sizeof(float));
+    memset(until + count, 0, tail * sizeof(float));
+    peaks->count = count;
+}
+
+void peaks_update(peaks_t *peaks, const float *levels, double now, double dt,
+                  double hold, double attack, double release) {
+    size_t n = padded(peaks->count);
+
+    if (now - peaks->epoch > PEAKS_REBASE_SECONDS) {
+        float shift = (float)(now - peaks->epoch);
+        for (size_t i = 0; i < n; i++) {
+            peaks->hold_until[i] -= shift;
+        }
+        peaks->epoch = now;
+    }
+
+    float t = (float)(now - peaks->epoch);
+    float rise = attack > 0.0 ? (float)(attack * dt) : FLT_MAX;
+    float fall = (float)(release * dt);
+
+    v8f now_v = (v8f){0} + t;
+    v8f deadline_v = (v8f){0} + (float)(t + hold);
+    v8f rise_v = (v8f){0} + rise;
+    v8f fall_v = (v8f){0} + fall;
+
+    // Per lane: a level at or above the peak pushes it up (rate-limited by
+    // attack) and restarts the hold; otherwise the peak stays until the
+    // deadline, then falls at the release rate but never below the level
+    for (size_t i = 0; i < n; i += PEAKS_LANES) {
+        v8f in;
+        memcpy(&in, levels + i, sizeof(in));
+        v8f value = *(const v8f *)(peaks->value + i);
+        v8f until = *(const v8f *)(peaks->hold_until + i);
+
+        v8i rising = in >= value;
+        v8i holding = now_v < until;
+
+        v8f raised = value + rise_v;
+        v8f up = SELECT_V8F(raised < in, raised, in);
+        v8f lowered = value - fall_v;
+        v8f down = SELECT_V8F(lowered > in, lowered, in);
+
+        v8f next = SELECT_V8F(rising, up, SELECT_V8F(holding, value, down));
+        *(v8f *)(peaks->value + i) = next;
+        *(v8f *)(peaks->hold_until + i) = SELECT_V8F(rising, deadline_v, until);
+    }
+}
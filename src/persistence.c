@@ -0,0 +1,78 @@
+#include "persistence.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+int persistence_init(persistence_t *p, size_t bins) {
+    memset(p, 0, sizeof(*p));
+    p->counts = calloc(bins * PERSISTENCE_LEVELS, sizeof(uint32_t));
+    if (!p->counts) {
+        return -1;
+    }
+    p->bins = bins;
+    p->weight = PERSISTENCE_RESCALE / (1 << PERSISTENCE_SHIFT);
+    persistence_set_decay(p, 48000.0 / PERSISTENCE_HOP, PERSISTENCE_TIME);
+    return 0;
+}
+
+void persistence_shutdown(persistence_t *p) {
+    free(p->counts);
+    memset(p, 0, sizeof(*p));
+}
+
+void persistence_clear(persistence_t *p) {
+    memset(p->counts, 0, sizeof(uint32_t) * p->bins * PERSISTENCE_LEVELS);
+    p->weight = PERSISTENCE_RESCALE / (1 << PERSISTENCE_SHIFT);
+}
+
+void persistence_set_decay(persistence_t *p, double frame_rate, double time) {
+    // Counters peak near weight * frames-per-time-constant; keep that in 32 bits
+    double frames = frame_rate * time;
+    if (frames > PERSISTENCE_MAX_FRAMES) frames = PERSISTENCE_MAX_FRAMES;
+    if (frames < 1.0) frames = 1.0;
+    p->frame_rate = frame_rate;
+    p->time = frames / frame_rate;
+    p->growth = exp(1.0 / frames);
+}
+
+void persistence_add(persistence_t *p, const double *spectrum) {
+    uint32_t hit = (uint32_t)p->weight;
+    for (size_t i = 0; i < p->bins; i++) {
+        // Below the floor counts as no hit so the background stays dark
+        double v = spectrum[i];
+        if (v <= 0.0) continue;
+        int level = (int)(v * PERSISTENCE_LEVELS);
+        if (level >= PERSISTENCE_LEVELS) level = PERSISTENCE_LEVELS - 1;
+        p->counts[i * PERSISTENCE_LEVELS + level] += hit;
+    }
+
+    // Rare full pass: plain shifts over a flat array, vectorized by the compiler
+    p->weight *= p->growth;
+    if (p->weight >= PERSISTENCE_RESCALE) {
+        size_t n = p->bins * PERSISTENCE_LEVELS;
+        uint32_t *counts = p->counts;
+        for (size_t i = 0; i < n; i++) {
+            counts[i] >>= PERSISTENCE_SHIFT;
+        }
+        p->weight /= 1 << PERSISTENCE_SHIFT;
+    }
+}
+
+void persistence_column(const persistence_t *p, size_t first, size_t last, float *levels) {
+    // A cell hit every frame converges to (last weight) / (1 - decay)
+    float scale = (float)((p->growth - 1.0) / p->weight);
+    if (last <= first) last = first + 1;
+    if (last > p->bins) last = p->bins;
+
+    uint32_t peak[PERSISTENCE_LEVELS] = {0};
+    for (size_t b = first; b < last; b++) {
+        const uint32_t *row = p->counts + b * PERSISTENCE_LEVELS;
+        for (int l = 0; l < PERSISTENCE_LEVELS; l++) {
+            peak[l] = row[l] > peak[l] ? row[l] : peak[l];
+        }
+    }
+    for (int l = 0; l < PERSISTENCE_LEVELS; l++) {
+        float density = peak[l] * scale;
+        levels[l] = density > 1.0f ? 1.0f : density;
+    }
+}
@@ -0,0 +1,103 @@
+#include "phase.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+void phase_shutdown(phase_ctx_t *p) {
+    free(p->scope);
+    memset(p, 0, sizeof(*p));
+}
+
+void phase_reset(phase_ctx_t *p) {
+    float *scope = p->scope;
+    int w = p->dots_w, h = p->dots_h;
+    memset(p, 0, sizeof(*p));
+    p->scope = scope;
+    p->dots_w = w;
+    p->dots_h = h;
+    if (scope) memset(scope, 0, sizeof(float) * w * h);
+}
+
+double phase_band_center(int band) {
+    return 1000.0 * pow(2.0, band - 5);
+}
+
+// Weight kept by a one-pole average with time constant tau after seconds
+static double keep(double seconds, double tau) {
+    return exp(-seconds / tau);
+}
+
+void phase_update_correlation(phase_ctx_t *p, double sum_lr, double sum_ll, double sum_rr, double seconds) {
+    double denom = sqrt(sum_ll * sum_rr);
+    double r = denom > 1e-20 ? sum_lr / denom : 0.0;
+    double k = keep(seconds, PHASE_CORRELATION_TIME);
+    p->correlation = k * p->correlation + (1.0 - k) * r;
+}
+
+void phase_update_bands(phase_ctx_t *p, const fftw_complex *left, const fftw_complex *right,
+                        size_t bins, int sample_rate, double seconds) {
+    double bin_hz = sample_rate / (2.0 * bins);
+    const double k = keep(seconds, PHASE_AVERAGING_TIME);
+    for (int b = 0; b < PHASE_BANDS; b++) {
+        double fc = phase_band_center(b);
+        size_t first = (size_t)(fc / M_SQRT2 / bin_hz + 0.5);
+        size_t last = (size_t)(fc * M_SQRT2 / bin_hz + 0.5);
+        if (first < 1) first = 1;
+        if (last > bins) last = bins;
+        if (last <= first) last = first + 1;
+
+        // Cross-spectrum L * conj(R), summed over the band
+        double xx = 0.0, yy = 0.0, re = 0.0, im = 0.0;
+        for (size_t i = first; i < last && i < bins; i++) {
+            double lr = left[i][0], li = left[i][1];
+            double rr = right[i][0], ri = right[i][1];
+            xx += lr * lr + li * li;
+            yy += rr * rr + ri * ri;
+            re += lr * rr + li * ri;
+            im += li * rr - lr * ri;
+        }
+
+        p->sxx[b] = k * p->sxx[b] + (1.0 - k) * xx;
+        p->syy[b] = k * p->syy[b] + (1.0 - k) * yy;
+        p->sxy_re[b] = k * p->sxy_re[b] + (1.0 - k) * re;
+        p->sxy_im[b] = k * p->sxy_im[b] + (1.0 - k) * im;
+
+        double power = p->sxx[b] * p->syy[b];
+        double cross = p->sxy_re[b] * p->sxy_re[b] + p->sxy_im[b] * p->sxy_im[b];
+        p->coherence[b] = power > 1e-30 ? cross / power : 0.0;
+        p->phase[b] = -atan2(p->sxy_im[b], p->sxy_re[b]) * 180.0 / M_PI;
+    }
+}
+
+int phase_update_scope(phase_ctx_t *p, const float *left, const float *right, size_t count,
+                       int dots_w, int dots_h, double gain, double seconds) {
+    if (dots_w <= 0 || dots_h <= 0) return -1;
+    if (p->dots_w != dots_w || p->dots_h != dots_h) {
+        free(p->scope);
+        p->scope = calloc((size_t)dots_w * dots_h, sizeof(float));
+        if (!p->scope) {
+            p->dots_w = p->dots_h = 0;
+            return -1;
+        }
+        p->dots_w = dots_w;
+        p->dots_h = dots_h;
+    }
+
+    size_t n = (size_t)dots_w * dots_h;
+    float decay = (float)keep(seconds, PHASE_SCOPE_DECAY_TIME);
+    for (size_t i = 0; i < n; i++) {
+        p->scope[i] *= decay;
+    }
+
+    // Goniometer orientation: mono on the vertical axis, side across
+    double scale = gain * M_SQRT1_2;
+    for (size_t i = 0; i < count; i++) {
+        double mid = (left[i] + right[i]) * scale;
+        double side = (right[i] - left[i]) * scale;
+        int x = (int)((side + 1.0) * 0.5 * (dots_w - 1) + 0.5);
+        int y = (int)((1.0 - mid) * 0.5 * (dots_h - 1) + 0.5);
+        if (x < 0 || x >= dots_w || y < 0 || y >= dots_h) continue;
+        p->scope[(size_t)y * dots_w + x] = 1.0f;
+    }
+    return 0;
+}
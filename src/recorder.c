@@ -0,0 +1,261 @@
+#include "recorder.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+constexpr size_t WAV_HEADER_SIZE = 58;  // RIFF + fmt (18) + fact + data headers
+
+static void put_u16(uint8_t *p, uint32_t v) {
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    put_u16(p, v & 0xffff);
+    put_u16(p + 2, v >> 16);
+}
+
+// WAVE_FORMAT_IEEE_FLOAT header; sizes are patched when the file closes
+static void wav_header(uint8_t *h, uint32_t rate, uint32_t channels, uint64_t frames) {
+    uint32_t block = channels * sizeof(float);
+    uint32_t data = (uint32_t)(frames * block);
+    memcpy(h, "RIFF", 4);
+    put_u32(h + 4, (uint32_t)(WAV_HEADER_SIZE - 8 + data));
+    memcpy(h + 8, "WAVEfmt ", 8);
+    put_u32(h + 16, 18);
+    put_u16(h + 20, 3);  // IEEE float
+    put_u16(h + 22, channels);
+    put_u32(h + 24, rate);
+    put_u32(h + 28, rate * block);
+    put_u16(h + 32, block);
+    put_u16(h + 34, 32);
+    put_u16(h + 36, 0);
+    memcpy(h + 38, "fact", 4);
+    put_u32(h + 42, 4);
+    put_u32(h + 46, (uint32_t)frames);
+    memcpy(h + 50, "data", 4);
+    put_u32(h + 54, data);
+}
+
+static void finish_capture(recorder_ctx_t *ctx) {
+    if (!ctx->file) return;
+
+    uint8_t header[WAV_HEADER_SIZE];
+    wav_header(header, ctx->sample_rate, ctx->channels, ctx->data_frames);
+    bool ok = fseek(ctx->file, 0, SEEK_SET) == 0 &&
+              fwrite(header, sizeof(header), 1, ctx->file) == 1;
+    ok = fclose(ctx->file) == 0 && ok;
+    ctx->file = NULL;
+    if (!ok) {
+        remove(ctx->path);
+    } else {
+        atomic_fetch_add(&ctx->captures, 1);
+    }
+    atomic_store(&ctx->recording, false);
+}
+
+static void write_frames(recorder_ctx_t *ctx, const float *frames, size_t count) {
+    if (fwrite(frames, sizeof(float) * ctx->channels, count, ctx->file) != count) {
+        ctx->end_frame = ctx->write_pos;  // disk full or gone: close what we have
+        return;
+    }
+    ctx->data_frames += count;
+}
+
+static int configure(recorder_ctx_t *ctx, uint32_t rate, uint32_t channels) {
+    finish_capture(ctx);
+    free(ctx->ring);
+    ctx->sample_rate = rate;
+    ctx->channels = channels;
+    ctx->ring_frames = (size_t)((ctx->pre_seconds + RECORDER_SLACK_SECONDS) * rate);
+    ctx->ring = malloc(sizeof(float) * ctx->ring_frames * channels);
+    ctx->ring_first = ctx->cursor;
+    return ctx->ring ? 0 : -1;
+}
+
+// Open a file and write the pre-trigger history held in the ring
+static void start_capture(recorder_ctx_t *ctx, uint64_t frame, const char *label) {
+    char stamp[32];
+    time_t now = time(NULL);
+    struct tm tm;
+    localtime_r(&now, &tm);
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &tm);
+    snprintf(ctx->path, sizeof(ctx->path), "%s/tspec-%s-%03u-%s.wav", ctx->directory, stamp,
+             atomic_load(&ctx->captures), label);
+
+    ctx->file = fopen(ctx->path, "wb");
+    if (!ctx->file) {
+        fprintf(stderr, "Failed to open %s\n", ctx->path);
+        return;
+    }
+    setvbuf(ctx->file, NULL, _IOFBF, RECORDER_FILE_BUFFER);
+    uint8_t header[WAV_HEADER_SIZE];
+    wav_header(header, ctx->sample_rate, ctx->channels, 0);
+    fwrite(header, sizeof(header), 1, ctx->file);
+
+    uint64_t pre = (uint64_t)(ctx->pre_seconds * ctx->sample_rate);
+    uint64_t from = frame > pre ? frame - pre : 0;
+    uint64_t oldest = ctx->cursor > ctx->ring_frames ? ctx->cursor - ctx->ring_frames : 0;
+    if (from < oldest) from = oldest;
+    if (from < ctx->ring_first) from = ctx->ring_first;
+
+    ctx->start_frame = frame;
+    ctx->end_frame = frame + (uint64_t)(ctx->post_seconds * ctx->sample_rate);
+    ctx->data_frames = 0;
+    ctx->write_pos = from;
+    atomic_store(&ctx->recording, true);
+
+    // History up to the drain cursor, as two spans around the ring wrap
+    while (ctx->write_pos < ctx->cursor && ctx->write_pos < ctx->end_frame) {
+        size_t pos = ctx->write_pos % ctx->ring_frames;
+        uint64_t limit = ctx->cursor < ctx->end_frame ? ctx->cursor : ctx->end_frame;
+        size_t count = ctx->ring_frames - pos;
+        if (count > limit - ctx->write_pos) count = (size_t)(limit - ctx->write_pos);
+        write_frames(ctx, ctx->ring + pos * ctx->channels, count);
+        ctx->write_pos += count;
+    }
+}
+
+// Store a drained chunk [start, start + count) in the ring and, while a
+// capture is open, append the part it still needs
+static void store_chunk(recorder_ctx_t *ctx, uint64_t start, size_t count) {
+    const uint32_t channels = ctx->channels;
+    for (size_t i = 0; i < count; i++) {
+        for (uint32_t c = 0; c < channels; c++) {
+            ctx->interleaved[i * channels + c] = ctx->scratch[c][i];
+        }
+    }
+
+    for (size_t done = 0; done < count;) {
+        size_t pos = (start + done) % ctx->ring_frames;
+        size_t span = ctx->ring_frames - pos;
+        if (span > count - done) span = count - done;
+        memcpy(ctx->ring + pos * channels, ctx->interleaved + done * channels,
+               sizeof(float) * span * channels);
+        done += span;
+    }
+
+    if (ctx->file) {
+        // A reader that fell behind skipped ahead; the gap is simply lost
+        if (ctx->write_pos < start) ctx->write_pos = start;
+        uint64_t end = start + count < ctx->end_frame ? start + count : ctx->end_frame;
+        if (ctx->write_pos < end) {
+            write_frames(ctx, ctx->interleaved + (ctx->write_pos - start) * channels,
+                         (size_t)(end - ctx->write_pos));
+            ctx->write_pos = end;
+        }
+        if (ctx->write_pos >= ctx->end_frame) {
+            finish_capture(ctx);
+        }
+    }
+}
+
+static void *recorder_thread(void *arg) {
+    recorder_ctx_t *ctx = arg;
+    struct timespec pause = {
+        .tv_sec = 0,
+        .tv_nsec = (long)(RECORDER_POLL_SECONDS * 1e9),
+    };
+
+    while (atomic_load(&ctx->running)) {
+        uint32_t rate = audio_get_sample_rate(ctx->audio);
+        uint32_t channels = audio_get_channels(ctx->audio);
+        if ((rate != ctx->sample_rate || channels != ctx->channels) && configure(ctx, rate, channels) != 0) {
+            fprintf(stderr, "Failed to allocate recorder history\n");
+            break;
+        }
+
+        pthread_mutex_lock(&ctx->lock);
+        bool pending = ctx->pending;
+        uint64_t frame = ctx->pending_frame;
+        char label[RECORDER_LABEL_LEN];
+        memcpy(label, ctx->pending_label, sizeof(label));
+        ctx->pending = false;
+        pthread_mutex_unlock(&ctx->lock);
+
+        if (pending && ctx->file) {
+            // Retrigger while recording extends the capture, up to a limit
+            uint64_t end = frame + (uint64_t)(ctx->post_seconds * ctx->sample_rate);
+            uint64_t limit = ctx->start_frame + (uint64_t)(RECORDER_MAX_SECONDS * ctx->sample_rate);
+            if (end > limit) end = limit;
+            if (end > ctx->end_frame) ctx->end_frame = end;
+        } else if (pending) {
+            start_capture(ctx, frame, label);
+        }
+
+        size_t count;
+        while ((count = audio_read(ctx->audio, &ctx->cursor, ctx->scratch, RECORDER_CHUNK)) > 0) {
+            store_chunk(ctx, ctx->cursor - count, count);
+        }
+        nanosleep(&pause, NULL);
+    }
+
+    finish_capture(ctx);
+    return NULL;
+}
+
+int recorder_init(recorder_ctx_t *ctx, audio_ctx_t *audio, const char *directory,
+                  double pre_seconds, double post_seconds) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->audio = audio;
+    ctx->directory = directory;
+    ctx->pre_seconds = pre_seconds;
+    ctx->post_seconds = post_seconds;
+    ctx->cursor = audio_frames_written(audio);
+    atomic_init(&ctx->running, false);
+    atomic_init(&ctx->recording, false);
+    atomic_init(&ctx->captures, 0);
+    pthread_mutex_init(&ctx->lock, NULL);
+
+    for (size_t c = 0; c < AUDIO_MAX_CHANNELS; c++) {
+        ctx->scratch[c] = malloc(sizeof(float) * RECORDER_CHUNK);
+        if (!ctx->scratch[c]) {
+            recorder_shutdown(ctx);
+            return -1;
+        }
+    }
+    ctx->interleaved = malloc(sizeof(float) * RECORDER_CHUNK * AUDIO_MAX_CHANNELS);
+    if (!ctx->interleaved ||
+        configure(ctx, audio_get_sample_rate(audio), audio_get_channels(audio)) != 0) {
+        recorder_shutdown(ctx);
+        return -1;
+    }
+
+    atomic_store(&ctx->running, true);
+    if (pthread_create(&ctx->thread, NULL, recorder_thread, ctx) != 0) {
+        atomic_store(&ctx->running, false);
+        recorder_shutdown(ctx);
+        return -1;
+    }
+    return 0;
+}
+
+void recorder_shutdown(recorder_ctx_t *ctx) {
+    if (atomic_exchange(&ctx->running, false)) {
+        pthread_join(ctx->thread, NULL);
+    }
+    for (size_t c = 0; c < AUDIO_MAX_CHANNELS; c++) {
+        free(ctx->scratch[c]);
+        ctx->scratch[c] = NULL;
+    }
+    free(ctx->interleaved);
+    free(ctx->ring);
+    ctx->interleaved = NULL;
+    ctx->ring = NULL;
+    if (ctx->audio) {
+        pthread_mutex_destroy(&ctx->lock);
+        ctx->audio = NULL;
+    }
+}
+
+void recorder_trigger(recorder_ctx_t *ctx, uint64_t frame, const char *label) {
+    pthread_mutex_lock(&ctx->lock);
+    ctx->pending = true;
+    ctx->pending_frame = frame;
+    snprintf(ctx->pending_label, sizeof(ctx->pending_label), "%s", label);
+    pthread_mutex_unlock(&ctx->lock);
+}
+
+bool recorder_active(recorder_ctx_t *ctx) {
+    return atomic_load(&ctx->recording);
+}
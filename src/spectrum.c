@@ -1,36 +1,93 @@
 #include "spectrum.h"
 #include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
-int spectrum_init(spectrum_ctx_t *ctx) {
+// Only fftw_execute is thread-safe; planning and plan destruction touch
+// the planner's global state, so contexts on other threads take turns
+static pthread_mutex_t planner_lock = PTHREAD_MUTEX_INITIALIZER;
+
+#ifdef TSPEC_HAVE_FFTW_THREADS
+static pthread_once_t threads_once = PTHREAD_ONCE_INIT;
+
+static void init_threads(void) {
+    fftw_init_threads();
+}
+#endif
+
+static void plan_threads(size_t channels) {
+#ifdef TSPEC_HAVE_FFTW_THREADS
+    int nthreads = 1;
+    if (channels * FFT_SIZE >= SPECTRUM_THREADS_MIN_SIZE) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = cpus > 1 ? (int)(cpus < (long)channels ? cpus : (long)channels) : 1;
+    }
+    fftw_plan_with_nthreads(nthreads);
+#else
+    (void)channels;
+#endif
+}
+
+int spectrum_init(spectrum_ctx_t *ctx, size_t channels) {
     memset(ctx, 0, sizeof(*ctx));
 
-    ctx->input = fftw_malloc(sizeof(double) * FFT_SIZE);
-    ctx->output = fftw_malloc(sizeof(fftw_complex) * (FFT_SIZE / 2 + 1));
-    ctx->magnitudes = malloc(sizeof(double) * SPECTRUM_BINS);
-    ctx->smoothed = malloc(sizeof(double) * SPECTRUM_BINS);
+#ifdef TSPEC_HAVE_FFTW_THREADS
+    pthread_once(&threads_once, init_threads);
+#endif
 
-    if (!ctx->input || !ctx->output || !ctx->magnitudes || !ctx->smoothed) {
+    if (channels < 1) channels = 1;
+    if (channels > SPECTRUM_MAX_CHANNELS) channels = SPECTRUM_MAX_CHANNELS;
+    ctx->channels = channels;
+
+    size_t views = channels + 1;
+    ctx->input = fftw_malloc(sizeof(double) * FFT_SIZE * channels);
+    ctx->output = fftw_malloc(sizeof(fftw_complex) * SPECTRUM_OUT_STRIDE * channels);
+    ctx->mix = fftw_malloc(sizeof(fftw_complex) * SPECTRUM_OUT_STRIDE);
+    ctx->window = malloc(sizeof(double) * FFT_SIZE);
+    ctx->magnitudes = malloc(sizeof(double) * SPECTRUM_BINS * views);
+    ctx->power = malloc(sizeof(double) * SPECTRUM_BINS * views);
+    ctx->average = malloc(sizeof(double) * SPECTRUM_BINS * views);
+    ctx->averaged = malloc(sizeof(double) * SPECTRUM_BINS * views);
+
+    if (!ctx->input || !ctx->output || !ctx->mix || !ctx->window || !ctx->magnitudes ||
+        !ctx->power || !ctx->average || !ctx->averaged) {
         spectrum_shutdown(ctx);
         return -1;
     }
 
-    ctx->plan = fftw_plan_dft_r2c_1d(FFT_SIZE, ctx->input, ctx->output, FFTW_MEASURE);
+    // All channels in one batched transform: contiguous FFT_SIZE-sample
+    // rows in, cache-line-padded rows out
+    int n = (int)FFT_SIZE;
+    pthread_mutex_lock(&planner_lock);
+    plan_threads(channels);
+    ctx->plan = fftw_plan_many_dft_r2c(1, &n, (int)channels,
+                                       ctx->input, NULL, 1, (int)FFT_SIZE,
+                                       ctx->output, NULL, 1, (int)SPECTRUM_OUT_STRIDE,
+                                       FFTW_MEASURE);
+    pthread_mutex_unlock(&planner_lock);
     if (!ctx->plan) {
         spectrum_shutdown(ctx);
         return -1;
     }
 
-    memset(ctx->smoothed, 0, sizeof(double) * SPECTRUM_BINS);
+    memset(ctx->input, 0, sizeof(double) * FFT_SIZE * channels);
+    memset(ctx->averaged, 0, sizeof(double) * SPECTRUM_BINS * views);
     ctx->smoothing = 0.8;
+    ctx->mode = SPECTRUM_AVG_EXP;
+    ctx->ring_frames = 9;  // (1 + 0.8) / (1 - 0.8)
+    spectrum_reset_average(ctx);
 
     return 0;
 }
 
 void spectrum_shutdown(spectrum_ctx_t *ctx) {
     if (ctx->plan) {
+        pthread_mutex_lock(&planner_lock);
         fftw_destroy_plan(ctx->plan);
+        pthread_mutex_unlock(&planner_lock);
     }
     if (ctx->input) {
         fftw_free(ctx->input);
@@ -38,45 +95,156 @@ void spectrum_shutdown(spectrum_ctx_t *ctx) {
     if (ctx->output) {
         fftw_free(ctx->output);
     }
+    if (ctx->mix) {
+        fftw_free(ctx->mix);
+    }
+    free(ctx->window);
     free(ctx->magnitudes);
-    free(ctx->smoothed);
+    free(ctx->power);
+    free(ctx->average);
+    free(ctx->averaged);
+    free(ctx->ring);
     memset(ctx, 0, sizeof(*ctx));
 }
 
-void spectrum_process(spectrum_ctx_t *ctx, const float *samples, size_t count) {
+// Power to a level normalized -80dB..0dB -> 0..1
+static double to_level(double power) {
+    double db = 10.0 * log10(power + 1e-20);
+    db = (db + SPECTRUM_DB_RANGE) / SPECTRUM_DB_RANGE;
+    if (db < 0.0) db = 0.0;
+    if (db > 1.0) db = 1.0;
+    return db;
+}
+
+static void update_view(spectrum_ctx_t *ctx, size_t view, const fftw_complex *bins, double scale) {
+    double *magnitudes = ctx->magnitudes + view * SPECTRUM_BINS;
+    double *power = ctx->power + view * SPECTRUM_BINS;
+
+    // Calculate power and magnitudes (dB scale)
+    for (size_t i = 0; i < SPECTRUM_BINS; i++) {
+        double re = bins[i][0];
+        double im = bins[i][1];
+        power[i] = (re * re + im * im) * scale * scale;
+
+        // Convert to dB, clamp to reasonable range
+        double db = to_level(power[i]);
+        magnitudes[i] = db;
+    }
+}
+
+void spectrum_analyze(spectrum_ctx_t *ctx, const float *const *samples, size_t count) {
     size_t copy_count = count < FFT_SIZE ? count : FFT_SIZE;
     size_t offset = FFT_SIZE - copy_count;
 
-    // Zero-pad if needed
-    for (size_t i = 0; i < offset; i++) {
-        ctx->input[i] = 0.0;
+    // Hann window is recomputed only when the block length changes
+    if (ctx->window_len != copy_count) {
+        for (size_t i = 0; i < copy_count; i++) {
+            ctx->window[i] = 0.5 * (1.0 - cos(2.0 * M_PI * i / (copy_count - 1)));
+        }
+        ctx->window_len = copy_count;
     }
 
-    // Apply Hann window
-    for (size_t i = 0; i < copy_count; i++) {
-        double window = 0.5 * (1.0 - cos(2.0 * M_PI * i / (copy_count - 1)));
-        ctx->input[offset + i] = samples[i] * window;
+    for (size_t c = 0; c < ctx->channels; c++) {
+        double *input = ctx->input + c * FFT_SIZE;
+
+        // Zero-pad if needed
+        for (size_t i = 0; i < offset; i++) {
+            input[i] = 0.0;
+        }
+
+        for (size_t i = 0; i < copy_count; i++) {
+            input[offset + i] = samples[c][i] * ctx->window[i];
+        }
     }
 
     fftw_execute(ctx->plan);
 
-    // Calculate magnitudes (dB scale)
+    for (size_t c = 0; c < ctx->channels; c++) {
+        update_view(ctx, c + 1, ctx->output + c * SPECTRUM_OUT_STRIDE, 1.0 / FFT_SIZE);
+    }
+
+    // The transform is linear, so the mix spectrum is the mean of the
+    // per-channel complex spectra and needs no transform of its own
+    if (ctx->channels == 1) {
+        update_view(ctx, 0, ctx->output, 1.0 / FFT_SIZE);
+        return;
+    }
+
     for (size_t i = 0; i < SPECTRUM_BINS; i++) {
-        double re = ctx->output[i][0];
-        double im = ctx->output[i][1];
-        double mag = sqrt(re * re + im * im) / FFT_SIZE;
+        ctx->mix[i][0] = ctx->output[i][0];
+        ctx->mix[i][1] = ctx->output[i][1];
+    }
+    for (size_t c = 1; c < ctx->channels; c++) {
+        const fftw_complex *row = ctx->output + c * SPECTRUM_OUT_STRIDE;
+        for (size_t i = 0; i < SPECTRUM_BINS; i++) {
+            ctx->mix[i][0] += row[i][0];
+            ctx->mix[i][1] += row[i][1];
+        }
+    }
+    update_view(ctx, 0, ctx->mix, 1.0 / (FFT_SIZE * ctx->channels));
+}
 
-        // Convert to dB, clamp to reasonable range
-        double db = 20.0 * log10(mag + 1e-10);
-        db = (db + 80.0) / 80.0;  // Normalize -80dB..0dB to 0..1
-        if (db < 0.0) db = 0.0;
-        if (db > 1.0) db = 1.0;
+void spectrum_process(spectrum_ctx_t *ctx, const float *const *samples, size_t count, double seconds) {
+    spectrum_analyze(ctx, samples, count);
+
+    size_t n = SPECTRUM_BINS * (ctx->channels + 1);
+    const double *power = ctx->power;
+    double *average = ctx->average;
+    double k = pow(ctx->smoothing, (seconds > 0.0 ? seconds : 0.0) / SPECTRUM_AVG_STEP_SECONDS);
+
+    switch (ctx->mode) {
+        case SPECTRUM_AVG_EXP:
+            if (ctx->frames == 0) k = 0.0;
+            for (size_t i = 0; i < n; i++) {
+                average[i] = k * average[i] + (1.0 - k) * power[i];
+            }
+            break;
+
+        case SPECTRUM_AVG_LINEAR: {
+            // Running sum over a ring of past frames: one add and one
+            // subtract per bin whatever N is. The sum is rebuilt from the
+            // ring once per lap so rounding can't accumulate.
+            float *slot = ctx->ring + ctx->ring_pos * n;
+            bool full = ctx->ring_count == ctx->ring_frames;
+            for (size_t i = 0; i < n; i++) {
+                if (full) average[i] -= slot[i];
+                slot[i] = (float)power[i];
+                average[i] += slot[i];
+            }
+            if (!full) ctx->ring_count++;
+            ctx->ring_pos = (ctx->ring_pos + 1) % ctx->ring_frames;
+            if (ctx->ring_pos == 0) {
+                memset(average, 0, sizeof(double) * n);
+                for (size_t f = 0; f < ctx->ring_count; f++) {
+                    const float *row = ctx->ring + f * n;
+                    for (size_t i = 0; i < n; i++) {
+                        average[i] += row[i];
+                    }
+                }
+            }
+            break;
+        }
+
+        case SPECTRUM_AVG_MAX:
+            for (size_t i = 0; i < n; i++) {
+                if (ctx->frames == 0 || power[i] > average[i]) average[i] = power[i];
+            }
+            break;
 
-        ctx->magnitudes[i] = db;
+        case SPECTRUM_AVG_MIN:
+            for (size_t i = 0; i < n; i++) {
+                if (ctx->frames == 0 || power[i] < average[i]) average[i] = power[i];
+            }
+            break;
 
-        // Exponential smoothing
-        ctx->smoothed[i] = ctx->smoothing * ctx->smoothed[i] +
-                          (1.0 - ctx->smoothing) * db;
+        default:
+            break;
+    }
+    ctx->frames++;
+
+    double scale = ctx->mode == SPECTRUM_AVG_LINEAR ? 1.0 / ctx->ring_count : 1.0;
+    for (size_t i = 0; i < n; i++) {
+        ctx->averaged[i] = to_level(average[i] * scale);
     }
 }
 
@@ -84,4 +252,56 @@ void spectrum_set_smoothing(spectrum_ctx_t *ctx, double smoothing) {
     if (smoothing < 0.0) smoothing = 0.0;
     if (smoothing > 0.99) smoothing = 0.99;
     ctx->smoothing = smoothing;
+
+    // Linear window with the same variance reduction as the exponential one
+    size_t frames = (size_t)((1.0 + smoothing) / (1.0 - smoothing) + 0.5);
+    if (frames < 1) frames = 1;
+    if (frames > SPECTRUM_AVG_MAX_FRAMES) frames = SPECTRUM_AVG_MAX_FRAMES;
+    if (frames != ctx->ring_frames) {
+        ctx->ring_frames = frames;
+        if (ctx->mode == SPECTRUM_AVG_LINEAR) spectrum_reset_average(ctx);
+    }
+}
+
+int spectrum_set_average(spectrum_ctx_t *ctx, spectrum_average_t mode) {
+    if (mode == ctx->mode) return 0;
+    if (mode == SPECTRUM_AVG_LINEAR && !ctx->ring) {
+        ctx->ring = malloc(sizeof(float) * SPECTRUM_AVG_MAX_FRAMES * SPECTRUM_BINS * (ctx->channels + 1));
+        if (!ctx->ring) return -1;
+    }
+    ctx->mode = mode;
+    spectrum_reset_average(ctx);
+    return 0;
+}
+
+void spectrum_reset_average(spectrum_ctx_t *ctx) {
+    memset(ctx->average, 0, sizeof(double) * SPECTRUM_BINS * (ctx->channels + 1));
+    ctx->ring_pos = 0;
+    ctx->ring_count = 0;
+    ctx->frames = 0;
+}
+
+const char *spectrum_average_name(spectrum_average_t mode) {
+    switch (mode) {
+        case SPECTRUM_AVG_EXP: return "exp";
+        case SPECTRUM_AVG_LINEAR: return "linear";
+        case SPECTRUM_AVG_MAX: return "max hold";
+        case SPECTRUM_AVG_MIN: return "min hold";
+        default: return "?";
+    }
+}
+
+const double *spectrum_view(const spectrum_ctx_t *ctx, size_t view) {
+    if (view > ctx->channels) view = 0;
+    return ctx->averaged + view * SPECTRUM_BINS;
+}
+
+const double *spectrum_levels(const spectrum_ctx_t *ctx, size_t view) {
+    if (view > ctx->channels) view = 0;
+    return ctx->magnitudes + view * SPECTRUM_BINS;
+}
+
+const fftw_complex *spectrum_channel_bins(const spectrum_ctx_t *ctx, size_t channel) {
+    if (channel >= ctx->channels) channel = 0;
+    return ctx->output + channel * SPECTRUM_OUT_STRIDE;
 }
@@ -0,0 +1,135 @@
+#include "tonal.h"
+#include "spectrum.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *NOTE_NAMES[] = {"C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"};
+
+void tonal_reset(tonal_ctx_t *ctx) {
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+static int by_level_desc(const void *a, const void *b) {
+    double da = ((const tonal_peak_t *)a)->dbfs;
+    double db = ((const tonal_peak_t *)b)->dbfs;
+    return (da < db) - (da > db);
+}
+
+// Local maxima and a level histogram for the median noise floor, in one
+// pass; only the strongest TONAL_MAX_PEAKS candidates are kept
+static void find_peaks(tonal_ctx_t *ctx, const double *levels, size_t bins, double bin_hz) {
+    typedef struct { size_t bin; double a, b, c; } candidate_t;
+    candidate_t found[TONAL_MAX_PEAKS];
+    int count = 0;
+    int weakest = 0;
+    unsigned hist[256] = {0};
+
+    for (size_t i = 1; i + 1 < bins; i++) {
+        double a = levels[i - 1], b = levels[i], c = levels[i + 1];
+        hist[(int)(b * 255.0)]++;
+        if (!(b > a && b >= c && b > 0.0)) continue;
+
+        if (count < TONAL_MAX_PEAKS) {
+            found[count++] = (candidate_t){i, a, b, c};
+        } else if (b > found[weakest].b) {
+            found[weakest] = (candidate_t){i, a, b, c};
+        } else {
+            continue;
+        }
+        for (int k = 0; k < count; k++) {
+            if (found[k].b < found[weakest].b) weakest = k;
+        }
+    }
+
+    size_t half = (bins - 2) / 2, seen = 0;
+    int median = 0;
+    while (median < 255 && (seen += hist[median]) <= half) median++;
+    ctx->floor_db = (median / 255.0 - 1.0) * SPECTRUM_DB_RANGE;
+
+    // Quadratic fit through the three log-magnitude points around each maximum
+    ctx->num_peaks = 0;
+    for (int k = 0; k < count; k++) {
+        const candidate_t *f = &found[k];
+        if ((f->b - 1.0) * SPECTRUM_DB_RANGE - ctx->floor_db < TONAL_MIN_SNR) continue;
+        double denom = f->a - 2.0 * f->b + f->c;
+        double p = denom < 0.0 ? 0.5 * (f->a - f->c) / denom : 0.0;
+        double level = f->b - 0.25 * (f->a - f->c) * p;
+        ctx->peaks[ctx->num_peaks++] = (tonal_peak_t){
+            .freq = (f->bin + p) * bin_hz,
+            .dbfs = (level - 1.0) * SPECTRUM_DB_RANGE + TONAL_HANN_GAIN_DB,
+        };
+    }
+    qsort(ctx->peaks, ctx->num_peaks, sizeof(tonal_peak_t), by_level_desc);
+}
+
+static void update_tracks(tonal_ctx_t *ctx, double bin_hz) {
+    bool matched[TONAL_MAX_TRACKS] = {false};
+
+    // Loudest peaks claim the nearest track first
+    for (int k = 0; k < ctx->num_peaks; k++) {
+        const tonal_peak_t *peak = &ctx->peaks[k];
+        int best = -1;
+        double best_dist = TONAL_TRACK_BINS * bin_hz;
+        for (int t = 0; t < TONAL_MAX_TRACKS; t++) {
+            double dist = fabs(ctx->tracks[t].freq - peak->freq);
+            if (ctx->tracks[t].active && !matched[t] && dist <= best_dist) {
+                best = t;
+                best_dist = dist;
+            }
+        }
+        if (best >= 0) {
+            tonal_track_t *track = &ctx->tracks[best];
+            track->freq = TONAL_FREQ_SMOOTHING * track->freq + (1.0 - TONAL_FREQ_SMOOTHING) * peak->freq;
+            track->dbfs = peak->dbfs;
+            track->age++;
+            track->missed = 0;
+            matched[best] = true;
+            continue;
+        }
+        for (int t = 0; t < TONAL_MAX_TRACKS; t++) {
+            if (!ctx->tracks[t].active) {
+                ctx->tracks[t] = (tonal_track_t){peak->freq, peak->dbfs, 1, 0, true};
+                matched[t] = true;
+                break;
+            }
+        }
+    }
+
+    tonal_peak_t ready[TONAL_MAX_TRACKS];
+    int num_ready = 0;
+    for (int t = 0; t < TONAL_MAX_TRACKS; t++) {
+        tonal_track_t *track = &ctx->tracks[t];
+        if (!track->active) continue;
+        if (!matched[t] && ++track->missed > TONAL_MAX_MISSED) {
+            track->active = false;
+            continue;
+        }
+        if (track->age >= TONAL_MIN_AGE) {
+            ready[num_ready++] = (tonal_peak_t){track->freq, track->dbfs};
+        }
+    }
+    qsort(ready, num_ready, sizeof(tonal_peak_t), by_level_desc);
+    ctx->num_top = num_ready < TONAL_TOP ? num_ready : TONAL_TOP;
+    memcpy(ctx->top, ready, sizeof(tonal_peak_t) * ctx->num_top);
+}
+
+void tonal_update(tonal_ctx_t *ctx, const double *levels, size_t bins, int sample_rate) {
+    if (bins < 3 || sample_rate <= 0) return;
+    double bin_hz = sample_rate / (2.0 * bins);
+    find_peaks(ctx, levels, bins, bin_hz);
+    update_tracks(ctx, bin_hz);
+}
+
+void tonal_note_name(double freq, char *buf, size_t size) {
+    if (freq <= 0.0) {
+        snprintf(buf, size, "-");
+        return;
+    }
+    double midi = 69.0 + 12.0 * log2(freq / 440.0);
+    long note = lround(midi);
+    int cents = (int)lround((midi - note) * 100.0);
+    int index = (int)(((note % 12) + 12) % 12);
+    snprintf(buf, size, "%s%ld %+dc", NOTE_NAMES[index], note / 12 - 1, cents);
+}
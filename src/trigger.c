@@ -0,0 +1,154 @@
+#include "trigger.h"
+#include "spectrum.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int trigger_add_rule(trigger_ctx_t *ctx, const char *spec) {
+    if (ctx->count >= TRIGGER_MAX_RULES) {
+        return -1;
+    }
+    trigger_rule_t rule = {0};
+    char tail;
+
+    if (sscanf(spec, "level:%lf%c", &rule.threshold, &tail) == 1) {
+        rule.kind = TRIGGER_LEVEL;
+    } else if (sscanf(spec, "band:%lf-%lf:%lf%c", &rule.low_hz, &rule.high_hz, &rule.threshold, &tail) == 3 &&
+               rule.low_hz >= 0.0 && rule.high_hz > rule.low_hz) {
+        rule.kind = TRIGGER_BAND;
+    } else if (sscanf(spec, "flux:%lf%c", &rule.threshold, &tail) == 1 && rule.threshold > 0.0) {
+        rule.kind = TRIGGER_FLUX;
+    } else {
+        return -1;
+    }
+
+    // Flux is a rise and never drops below zero, so it re-arms at half the threshold
+    rule.rearm = rule.kind == TRIGGER_FLUX ? rule.threshold / 2.0 : rule.threshold - TRIGGER_REARM_DB;
+    rule.armed = true;
+
+    // Keep the name usable as part of a file name
+    snprintf(rule.name, sizeof(rule.name), "%s", spec);
+    for (char *c = rule.name; *c; c++) {
+        if (*c == ':' || *c == '/' || *c == ' ') *c = '_';
+    }
+    ctx->rules[ctx->count++] = rule;
+    ctx->spectral |= rule.kind != TRIGGER_LEVEL;
+    return 0;
+}
+
+void trigger_shutdown(trigger_ctx_t *ctx) {
+    free(ctx->previous);
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+unsigned trigger_scan(trigger_ctx_t *ctx, const float *const *samples, size_t channels, size_t count,
+                      int sample_rate, size_t *offset) {
+    // Compare linear peaks so the per-frame loop needs no log
+    float fire[TRIGGER_MAX_RULES], rearm[TRIGGER_MAX_RULES];
+    for (int r = 0; r < ctx->count; r++) {
+        fire[r] = (float)pow(10.0, ctx->rules[r].threshold / 20.0);
+        rearm[r] = (float)pow(10.0, ctx->rules[r].rearm / 20.0);
+    }
+    size_t hold = (size_t)(TRIGGER_HOLD_SECONDS * sample_rate);
+
+    unsigned fired = 0;
+    for (size_t i = 0; i < count; i++) {
+        float peak = 0.0f;
+        for (size_t c = 0; c < channels; c++) {
+            float v = fabsf(samples[c][i]);
+            if (v > peak) peak = v;
+        }
+        for (int r = 0; r < ctx->count; r++) {
+            trigger_rule_t *rule = &ctx->rules[r];
+            if (rule->kind != TRIGGER_LEVEL) continue;
+            if (peak > fire[r]) {
+                if (rule->armed) {
+                    if (!fired) *offset = i;
+                    fired |= 1u << r;
+                }
+                rule->armed = false;
+                rule->quiet = 0;
+            } else if (peak > rearm[r]) {
+                rule->quiet = 0;
+            } else if (!rule->armed && ++rule->quiet >= hold) {
+                rule->armed = true;
+            }
+        }
+    }
+    return fired;
+}
+
+// Levels are normalized dB (0..1 over SPECTRUM_DB_RANGE); sum them as power.
+// Bins at the floor are clamped, not measured, and would add up to a level
+// of their own across a wide band, so they are left out
+static double band_db(const double *spectrum, size_t bins, int sample_rate, double low, double high) {
+    double bin_hz = sample_rate / (2.0 * bins);
+    size_t first = (size_t)(low / bin_hz);
+    size_t last = (size_t)ceil(high / bin_hz);
+    if (last > bins) last = bins;
+    double power = 0.0;
+    for (size_t i = first; i < last; i++) {
+        if (spectrum[i] <= 0.0) continue;
+        power += pow(10.0, (spectrum[i] - 1.0) * SPECTRUM_DB_RANGE / 10.0);
+    }
+    return 10.0 * log10(power + 1e-20);
+}
+
+static double flux_db(trigger_ctx_t *ctx, const double *spectrum, size_t bins) {
+    double rise = 0.0;
+    for (size_t i = 0; i < bins; i++) {
+        double d = spectrum[i] - ctx->previous[i];
+        if (d > 0.0) rise += d;
+    }
+    return rise * SPECTRUM_DB_RANGE / bins;
+}
+
+unsigned trigger_eval(trigger_ctx_t *ctx, const double *spectrum, size_t bins, int sample_rate) {
+    if (ctx->bins != bins) {
+        free(ctx->previous);
+        ctx->previous = malloc(sizeof(double) * bins);
+        ctx->bins = ctx->previous ? bins : 0;
+        ctx->has_previous = false;
+        if (!ctx->previous) return 0;
+    }
+
+    unsigned fired = 0;
+    for (int r = 0; r < ctx->count; r++) {
+        trigger_rule_t *rule = &ctx->rules[r];
+        double value;
+        switch (rule->kind) {
+            case TRIGGER_BAND:
+                value = band_db(spectrum, bins, sample_rate, rule->low_hz, rule->high_hz);
+                break;
+            case TRIGGER_FLUX:
+                if (!ctx->has_previous) continue;
+                value = flux_db(ctx, spectrum, bins);
+                break;
+            default:
+                continue;
+        }
+        // Each value already spans a whole window, so one hop below re-arms
+        if (value > rule->threshold) {
+            if (rule->armed) {
+                fired |= 1u << r;
+            }
+            rule->armed = false;
+        } else if (value <= rule->rearm) {
+            rule->armed = true;
+        }
+    }
+
+    memcpy(ctx->previous, spectrum, sizeof(double) * bins);
+    ctx->has_previous = true;
+    return fired;
+}
+
+void trigger_label(const trigger_ctx_t *ctx, unsigned fired, char *buf, size_t size) {
+    size_t len = 0;
+    buf[0] = '\0';
+    for (int r = 0; r < ctx->count && len < size; r++) {
+        if (!(fired & (1u << r))) continue;
+        len += snprintf(buf + len, size - len, "%s%s", len ? "+" : "", ctx->rules[r].name);
+    }
+}
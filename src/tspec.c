@@ -0,0 +1,142 @@
+#include "tspec.h"
+#include "audio.h"
+#include "binmap.h"
+#include "spectrum.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static_assert(TSPEC_FFT_SIZE == FFT_SIZE, "public and internal window sizes differ");
+static_assert(TSPEC_MAX_CHANNELS == SPECTRUM_MAX_CHANNELS, "public and internal channel limits differ");
+static_assert((int)TSPEC_DB_RANGE == (int)SPECTRUM_DB_RANGE, "public and internal level ranges differ");
+static_assert((int)TSPEC_AVG_MIN == (int)SPECTRUM_AVG_MIN, "average modes are passed through by value");
+
+struct tspec {
+    spectrum_ctx_t spectrum;
+    uint32_t sample_rate;
+};
+
+struct tspec_capture {
+    audio_ctx_t audio;
+};
+
+tspec_t *tspec_create(const tspec_config_t *config) {
+    if (config->channels < 1 || config->channels > TSPEC_MAX_CHANNELS || config->sample_rate == 0) return NULL;
+
+    tspec_t *t = calloc(1, sizeof(*t));
+    if (!t) return NULL;
+    if (spectrum_init(&t->spectrum, config->channels) != 0) {
+        free(t);
+        return NULL;
+    }
+    t->sample_rate = config->sample_rate;
+    spectrum_set_smoothing(&t->spectrum, config->smoothing);
+
+    // The linear average's ring is the only lazy allocation; do it now
+    if (spectrum_set_average(&t->spectrum, (spectrum_average_t)config->average) != 0) {
+        tspec_destroy(t);
+        return NULL;
+    }
+    return t;
+}
+
+void tspec_destroy(tspec_t *t) {
+    if (!t) return;
+    spectrum_shutdown(&t->spectrum);
+    free(t);
+}
+
+int tspec_process(tspec_t *t, const float *const *samples, size_t count) {
+    if (count < 2) return -1;  // a one-point Hann window divides by zero
+    spectrum_process(&t->spectrum, samples, count, (double)count / t->sample_rate);
+    return 0;
+}
+
+void tspec_set_smoothing(tspec_t *t, double smoothing) {
+    if (smoothing < 0.0) smoothing = 0.0;
+    if (smoothing > 0.99) smoothing = 0.99;
+    spectrum_set_smoothing(&t->spectrum, smoothing);
+}
+
+void tspec_reset(tspec_t *t) {
+    spectrum_reset_average(&t->spectrum);
+}
+
+size_t tspec_levels(const tspec_t *t, size_t view, double *out, size_t max) {
+    if (view > t->spectrum.channels) return 0;
+    size_t count = max < TSPEC_BINS ? max : TSPEC_BINS;
+    memcpy(out, spectrum_view(&t->spectrum, view), sizeof(double) * count);
+    return count;
+}
+
+int tspec_bands(const tspec_t *t, size_t view, float *out, int n) {
+    if (view > t->spectrum.channels || n <= 0) return -1;
+    const double *levels = spectrum_view(&t->spectrum, view);
+    for (int col = 0; col < n; col++) {
+        out[col] = (float)levels[bin_map_column(col, n, (int)t->sample_rate, TSPEC_BINS)];
+    }
+    return 0;
+}
+
+void tspec_stats(const float *const *samples, uint32_t channels, size_t count, tspec_stats_t *out) {
+    memset(out, 0, sizeof(*out));
+    if (channels > TSPEC_MAX_CHANNELS) channels = TSPEC_MAX_CHANNELS;
+    if (count == 0) return;
+
+    double sum_sq[TSPEC_MAX_CHANNELS] = {0};
+    for (uint32_t c = 0; c < channels; c++) {
+        double peak = 0.0, sq = 0.0;
+        for (size_t i = 0; i < count; i++) {
+            double v = samples[c][i];
+            double a = fabs(v);
+            if (a > peak) peak = a;
+            sq += v * v;
+        }
+        if (peak > out->peak) out->peak = peak;
+        sum_sq[c] = sq;
+        out->rms[c] = sqrt(sq / count);
+    }
+
+    if (channels >= 2) {
+        double sum_lr = 0.0;
+        for (size_t i = 0; i < count; i++) {
+            sum_lr += (double)samples[0][i] * samples[1][i];
+        }
+        double denom = sqrt(sum_sq[0] * sum_sq[1]);
+        out->correlation = denom > 1e-20 ? sum_lr / denom : 0.0;
+    }
+}
+
+tspec_capture_t *tspec_capture_open(const char *client_name) {
+    tspec_capture_t *capture = calloc(1, sizeof(*capture));
+    if (!capture) return NULL;
+    if (audio_init(&capture->audio, client_name) != 0) {
+        audio_shutdown(&capture->audio);
+        free(capture);
+        return NULL;
+    }
+    return capture;
+}
+
+void tspec_capture_close(tspec_capture_t *capture) {
+    if (!capture) return;
+    audio_shutdown(&capture->audio);
+    free(capture);
+}
+
+size_t tspec_capture_read(tspec_capture_t *capture, uint64_t *cursor, float *const *dest, size_t max) {
+    return audio_read(&capture->audio, cursor, dest, max);
+}
+
+uint64_t tspec_capture_position(tspec_capture_t *capture) {
+    return audio_frames_written(&capture->audio);
+}
+
+uint32_t tspec_capture_rate(tspec_capture_t *capture) {
+    return audio_get_sample_rate(&capture->audio);
+}
+
+uint32_t tspec_capture_channels(tspec_capture_t *capture) {
+    return audio_get_channels(&capture->audio);
+}